@@ -69,6 +69,35 @@
  *                          Code clean up switch to %.2f on sprintf 
  *           2026-04-16 RJB Corrections on handling sht1_humid and sht1_temp for derived observations
  *           2026-04-29 RJB Correction in Wind_SampleSpeed() on delta_ms.
+ *           2026-10-17 RJB Added binary observation frame (LB), selected with obs_format=1 in CONFIG.TXT
+ *                          Bug fix on hth observation, value was stored in f_obs and reported from i_obs
+ *                          obs_format=2 sends OBS and INFO JSON once as LF fragments, header not repeated
+ *                          Fixed INFO.TXT missing comma before sensors and doubled quote after MUX sensors
+ *                          LR messages packed First Fit Decreasing up to LORA_MAX_MSGLEN, packet count logged
+ *                          Added LoRaAirtime() and lora_dutycycle rolling hour airtime budget, INFO dropped first
+ *                          Added lora_ack gateway ACK window and lora_adr Spreading Factor 7-12 stepping, acked SF kept in EEPROM
+ *                          Added lora_retries reliable mode, resend until acked with jittered exponential backoff
+ *                          Added lora_lbt listen before talk, CAD with random doubling backoff
+ *                          Added lora_slots/lora_slotwidth, observation taken on boundary, sent in unit's slot
+ *                          AES key schedule expanded once, IV built as aes_myiv twice, lora_cipher=1 AES-CTR with no padding
+ *                          Added crc.cpp table driven CRC-16/CCITT, lora_crc=1 uses it for the message check bytes
+ *                          Transmit pipelined, next message encrypted while last is on air, delay(500) replaced by airtime spacing
+ *                          OBS and INFO log awake and radio idle ms per send cycle
+ *                          n2s_rate, unsent LR/LB messages queued to N2S.DAT on SD and resent after a good send
+ *                          obs_batch=N, N observations sent together as one delta encoded LM message every N periods
+ *                          info_compact=1, INFO fingerprint (ifp), full INFO only on change or gateway request
+ *                          obs_format=3, LD binary deltas against the last delivered observation, obs_keyframe
+ *                          Added msgw.cpp bounded message writer, LR/IF messages written once in place in msgbuf
+ *                          Fixed sensor[16] overflow in OBS_Send on long tags, INFO parts split, not cut
+ *                          lora_timesync, gateway time beacons in the ACK keep the RTC, median of 5, TQ when RTC not set
+ *                          lora_relay, store and relay of neighbor frames to the gateway, hop count in RH flags
+ *                          lora_channels, 915 MHz frequency hopping by unitid and Transmit Counter, per channel dwell limit
+ *                          Transmit priority classes, INFO and events deferred behind an observation waiting for its slot
+ *                          Sensor registry obs_registry[] with tag, type, decimals and QC class, OBS_Add() bounds checked
+ *                          SENSOR packed to 6 bytes, obs sensor RAM 2048 to 384 bytes, OBS RAM logged at boot
+ *                          MSGW_Fmt() fixed point formatter without printf for obs, INFO and StationMonitor values
+ *                          OBS_Trigger() starts DS18B20, TSM and TLW conversions, collected at the end of OBS_Take, times logged
+ *                          dst_resolution=9-12 DS18B20 resolution, scratchpad CRC-8 checked with a retry, boot scan converts all at once
  * 
  * Time Format: 2022:09:19:19:10:00  YYYY:MM:DD:HR:MN:SS  Enter UTC time and not local time.
  * 
@@ -220,11 +249,12 @@
 #include "include/wrda.h"
 #include "include/cf.h"
 #include "include/sdcard.h"
-#include "include/info.h"
 #include "include/dsmux.h"
 #include "include/sensors_i2c_44_47.h"
 #include "include/sensors.h"
 #include "include/output.h"
+#include "include/msgw.h"
+#include "include/info.h"
 #include "include/lora.h"
 #include "include/statmon.h"
 #include "include/support.h"
@@ -310,6 +340,7 @@ void setup()
   if (RTC_valid) {
     Output("RTC: Valid");
     EEPROM_initialize();
+    SD_N2S_Check();
   }
   else {
     Output("RTC: Not Valid");
@@ -406,6 +437,8 @@ void setup()
 
   lora_initialize();
 
+  OBS_RamReport();
+
   // Set a time to force the first observation
   // It doesn't matter if we are setting to a bad clock source. We handle the bad clock issue in loop()
   wakeuptime = now.unixtime();
@@ -485,11 +518,16 @@ void loop()
       SD_ClearRainTotals(); 
     }
         
-    // Every 24 hours send INFO
+    // Slotted send of the observation taken at the period boundary
+    OBS_SendPending();
+
+    // Every 24 hours send INFO, after any observation waiting for its slot has gone
+    // Held back INFO, observation waiting or duty cycle, is tried again the next time we wake
     
-    if (now.unixtime() > nextinfo) {      // Upon power on this will be true
-      INFO_Do();
-      nextinfo = now.unixtime() + (3600 * 24);      
+    if ((now.unixtime() > nextinfo) || LoRaInfoRequest) {      // Upon power on this will be true
+      if (INFO_Do()) {
+        nextinfo = now.unixtime() + (3600 * 24);      
+      }
     }
 
     // Upon power on this will be true
@@ -506,7 +544,11 @@ void loop()
     // Update the RTC clock from GPS. 
     if (gps_exists) {
       if (gps_on || (millis() >= nextTimeRefresh)) {
-        if (rtc_refresh()) {
+        if (!gps_on && LoRaTimeSynced()) {
+          // Gateway time beacons are keeping the RTC, save powering the GPS
+          nextTimeRefresh = millis() + (3600 * RTC_UPDATE_INTERVAL) * 1000;
+        }
+        else if (rtc_refresh()) {
           // Time should be set and gps should be off, lets get a gps time update in N hours.
           nextTimeRefresh = millis() + (3600 * RTC_UPDATE_INTERVAL) * 1000;
         }
@@ -522,15 +564,22 @@ void loop()
     }
 
     unsigned long stno = seconds_to_next_obs();
+    unsigned long stsleep = stno;
+    int stts = OBS_SecondsToSend();
+
+    // Wake early for our transmit slot, the observation time stays on the boundary
+    if ((stts >= 0) && ((unsigned long) stts < stsleep)) {
+      stsleep = stts;
+    }
       
-    if (stno <= 2) {
+    if (stsleep <= 2) {
       // Avoid going to sleep if there is 2s or less time until we need to do an observation
       // This is really here to address going into low power move for a fraction of a second.
       Output("Delay - Not Sleep");
       delay (GoToSleepTime);
     }
     else {  
-      sprintf (Buffer32Bytes, "Sleep for %us", stno);
+      sprintf (Buffer32Bytes, "Sleep for %us", stsleep);
       Output (Buffer32Bytes);  
 
       LoRaSleep();
@@ -538,7 +587,7 @@ void loop()
       OLED_sleepDisplay();
 
       wakeuptime = stno + now.unixtime(); // "now" was updated in the seconds_to_next_obs() function
-      LowPower.sleep(stno*1000); // uses milliseconds
+      LowPower.sleep(stsleep*1000); // uses milliseconds
  
       OLED_wakeDisplay();   // May need to toggle the Display reset pin.
       delay(2000);
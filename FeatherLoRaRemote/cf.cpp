@@ -9,9 +9,13 @@
 
 #include "include/ssbits.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/lora.h"
 #include "include/wrda.h"
+#include "include/obsbin.h"
+#include "include/obs.h"
 #include "include/main.h"
+#include "include/sdcard.h"
 #include "include/cf.h"
 
 /*
@@ -25,6 +29,25 @@ int cf_lora_unitid=2;
 int cf_lora_gwid=1;
 int cf_lora_txpower=13;
 int cf_lora_freq=915;
+int cf_lora_dutycycle=0;
+int cf_lora_ack=0;
+int cf_lora_adr=0;
+int cf_lora_retries=0;
+int cf_lora_lbt=0;
+int cf_lora_cipher=0;
+int cf_lora_crc=0;
+int cf_n2s_rate=0;
+int cf_lora_timesync=0;
+int cf_lora_slots=0;
+int cf_lora_slotwidth=10;
+int cf_lora_relay=0;
+int cf_lora_channels=0;
+long cf_lora_chbase=903900;
+int cf_lora_chspace=200;
+int cf_obs_format=0;
+int cf_obs_batch=0;
+int cf_obs_keyframe=OBSBIN_KEYFRAME;
+int cf_info_compact=0;
 // Instruments
 int cf_nowind=0;
 int cf_rg1_enable=0;
@@ -33,6 +56,7 @@ int cf_op2;
 int cf_op3;
 int cf_op4;
 int cf_ds_baseline=0;
+int cf_dst_resolution=12;
 int cf_elevation=0;
 // System Timing
 int cf_obs_period=15;
@@ -297,6 +321,83 @@ void SD_ReadConfigFile() {
   if (cf_lora_freq <= 0) { cf_lora_freq = 915; } // Safty Check
   sprintf(msgbuf, "%s=[%d]",  F("CF:lora_freq"), cf_lora_freq);       Output (msgbuf);
 
+  // Duty cycle in tenths of a percent, 0 = no limit
+  cf_lora_dutycycle = SD_findInt(F("lora_dutycycle"));
+  if ((cf_lora_dutycycle < 0) || (cf_lora_dutycycle > 1000)) { cf_lora_dutycycle = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_dutycycle"), cf_lora_dutycycle); Output (msgbuf);
+
+  // Gateway ACK and Adaptive Data Rate, ADR needs ACK
+  cf_lora_ack    = (SD_findInt(F("lora_ack")) == 1) ? 1 : 0;
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_ack"), cf_lora_ack);         Output (msgbuf);
+
+  cf_lora_adr    = ((SD_findInt(F("lora_adr")) == 1) && cf_lora_ack) ? 1 : 0;
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_adr"), cf_lora_adr);         Output (msgbuf);
+
+  // Reliable mode retries, needs ACK
+  cf_lora_retries = SD_findInt(F("lora_retries"));
+  if ((cf_lora_retries < 0) || (cf_lora_retries > LORA_RETRY_MAX) || !cf_lora_ack) { cf_lora_retries = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_retries"), cf_lora_retries); Output (msgbuf);
+
+  // Listen before talk
+  cf_lora_lbt    = (SD_findInt(F("lora_lbt")) == 1) ? 1 : 0;
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_lbt"), cf_lora_lbt);         Output (msgbuf);
+
+  // Cipher 0=CBC, 1=CTR
+  cf_lora_cipher = (SD_findInt(F("lora_cipher")) == LORA_CIPHER_CTR) ? LORA_CIPHER_CTR : LORA_CIPHER_CBC;
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_cipher"), cf_lora_cipher);   Output (msgbuf);
+
+  // Message check 0=Sum, 1=CRC16
+  cf_lora_crc    = (SD_findInt(F("lora_crc")) == 1) ? 1 : 0;
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_crc"), cf_lora_crc);         Output (msgbuf);
+
+  // Frequency hopping, 915 MHz only, every channel has to be in the 902-928 MHz band
+  cf_lora_channels = SD_findInt(F("lora_channels"));
+  cf_lora_chbase   = SD_findLong(F("lora_chbase"));
+  cf_lora_chspace  = SD_findInt(F("lora_chspace"));
+  if (cf_lora_chbase <= 0) { cf_lora_chbase = 903900; }  // Safty Check
+  if (cf_lora_chspace <= 0) { cf_lora_chspace = 200; }  // Safty Check
+  if ((cf_lora_channels < 0) || (cf_lora_channels > LORA_CH_MAX) || (cf_lora_freq != 915) ||
+      (cf_lora_chbase < 902000L) || ((cf_lora_chbase + ((long) (cf_lora_channels - 1) * cf_lora_chspace)) > 928000L)) { 
+    cf_lora_channels = 0; // Safty Check
+  }
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_channels"), cf_lora_channels); Output (msgbuf);
+  sprintf(msgbuf, "%s=[%ld]", F("CF:lora_chbase"), cf_lora_chbase);    Output (msgbuf);
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_chspace"), cf_lora_chspace);  Output (msgbuf);
+
+  // Gateway time beacons, seconds of error before the RTC is stepped
+  cf_lora_timesync = SD_findInt(F("lora_timesync"));
+  if (cf_lora_timesync < 0) { cf_lora_timesync = 0; } // Safty Check
+  if (cf_lora_timesync && (cf_lora_timesync < LORA_TIME_MIN)) { cf_lora_timesync = LORA_TIME_MIN; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_timesync"), cf_lora_timesync);         Output (msgbuf);
+
+  // Need to Send queue, messages replayed per observation
+  cf_n2s_rate    = SD_findInt(F("n2s_rate"));
+  if ((cf_n2s_rate < 0) || (cf_n2s_rate > SD_N2S_RATE_MAX)) { cf_n2s_rate = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:n2s_rate"), cf_n2s_rate);         Output (msgbuf);
+
+  // Observation message format 0=JSON, 1=Binary, 2=JSON Fragmented
+  cf_obs_format  = SD_findInt(F("obs_format"));
+  if ((cf_obs_format != OBS_FORMAT_JSON) && (cf_obs_format != OBS_FORMAT_BINARY) && (cf_obs_format != OBS_FORMAT_FRAG) &&
+      (cf_obs_format != OBS_FORMAT_DELTA)) { 
+    cf_obs_format = OBS_FORMAT_JSON;  // Safty Check
+  }
+  sprintf(msgbuf, "%s=[%d]",  F("CF:obs_format"), cf_obs_format);     Output (msgbuf);
+
+  // Observations between LD keyframes
+  cf_obs_keyframe = SD_findInt(F("obs_keyframe"));
+  if ((cf_obs_keyframe < 1) || (cf_obs_keyframe > 255)) { cf_obs_keyframe = OBSBIN_KEYFRAME; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:obs_keyframe"), cf_obs_keyframe);     Output (msgbuf);
+
+  // Observations per LM message, 0 or 1 = send each observation
+  cf_obs_batch   = SD_findInt(F("obs_batch"));
+  if ((cf_obs_batch < 0) || (cf_obs_batch > OBSBIN_BATCH_MAX)) { cf_obs_batch = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:obs_batch"), cf_obs_batch);     Output (msgbuf);
+
+  // Full INFO only when the fingerprint changes
+  cf_info_compact = SD_findInt(F("info_compact"));
+  if ((cf_info_compact < 0) || (cf_info_compact > 1)) { cf_info_compact = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:info_compact"), cf_info_compact);     Output (msgbuf);
+
   // No Wind = 1
   cf_nowind      = SD_findInt(F("nowind"));
   sprintf(msgbuf, "CF:%s=[%d]", F("nowind"), cf_nowind); Output (msgbuf);
@@ -371,11 +472,30 @@ void SD_ReadConfigFile() {
   cf_ds_baseline = SD_findInt(F("ds_baseline"));
   sprintf(msgbuf, "%s=[%d]",  F("CF:ds_baseline"), cf_ds_baseline);   Output (msgbuf);
 
+  cf_dst_resolution = SD_findInt(F("dst_resolution"));
+  if ((cf_dst_resolution < 9) || (cf_dst_resolution > 12)) { cf_dst_resolution = 12; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:dst_resolution"), cf_dst_resolution);   Output (msgbuf);
+
   // System Timing
   cf_obs_period   = SD_findInt(F("obs_period"));
   if (cf_obs_period <= 0) { cf_obs_period = 15; } // Safty Check
   sprintf(msgbuf, "%s=[%d]",  F("CF:obs_period"), cf_obs_period);     Output (msgbuf);
 
+  // Transmit slots, needs obs_period. Last slot has to finish before the next period's samples start
+  cf_lora_slots     = SD_findInt(F("lora_slots"));
+  cf_lora_slotwidth = SD_findInt(F("lora_slotwidth"));
+  if (cf_lora_slotwidth <= 0) { cf_lora_slotwidth = 10; } // Safty Check
+  if ((cf_lora_slots < 0) || ((cf_lora_slots * cf_lora_slotwidth) > ((cf_obs_period * 60) - 60))) { 
+    cf_lora_slots = 0; // Safty Check
+  }
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_slots"), cf_lora_slots);     Output (msgbuf);
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_slotwidth"), cf_lora_slotwidth); Output (msgbuf);
+
+  // Relay, seconds to listen for neighbors, has to end before the next period's samples start
+  cf_lora_relay     = SD_findInt(F("lora_relay"));
+  if ((cf_lora_relay < 0) || (cf_lora_relay > ((cf_obs_period * 60) - 60))) { cf_lora_relay = 0; } // Safty Check
+  sprintf(msgbuf, "%s=[%d]",  F("CF:lora_relay"), cf_lora_relay);     Output (msgbuf);
+
   cf_rtro = SD_findCharStr(F("rtro"));
   sprintf(msgbuf, "CF:%s=[%s]", F("rtro"), cf_rtro); Output (msgbuf);
   cf_rtro_validate();
@@ -5,7 +5,11 @@
  */
 #include "include/qc.h"
 #include "include/obs.h"
+#include "include/obsreg.h"
+#include "include/crc.h"
+#include "include/cf.h"
 #include "include/output.h"
+#include "include/support.h"
 #include "include/dsmux.h"
 #include "include/main.h"
 
@@ -18,6 +22,9 @@
 
  bool DSMUX_exists = false;
  bool dsmux_sensor_exists[DS248X_CHANNELS];
+ bool dsmux_triggered = false;
+ unsigned long dsmux_convert_ms = DS18B20_CONVERT_MS;  // Conversion wait for cf_dst_resolution
+ unsigned long dsmux_trigger_ms = 0;  // millis() when conversions were started
 
  /*
  * ======================================================================================================================
@@ -27,40 +34,130 @@
 
 /* 
  *=======================================================================================================================
- * dsmux_readTemperature() - 
+ * dsmux_convert() - Start a temperature conversion on channel, false if the channel could not be selected
  *=======================================================================================================================
  */
-float dsmux_readTemperature(uint8_t channel) {
+bool dsmux_convert(uint8_t channel) {
   // Select the channel on the DS2482-800
   if (!ds248x.selectChannel(channel)) {
     // Handle error if channel selection fails
     Output("DSMUX:Select CH Err");
-    return NAN; // Return 'Not a Number' to indicate an error
+    return (false);
   }
 
   // Start temperature conversion
   ds248x.OneWireReset();
   ds248x.OneWireWriteByte(DS18B20_CMD_SKIP_ROM); // Skip ROM command
   ds248x.OneWireWriteByte(DS18B20_CMD_CONVERT_T); // Convert T command
-  delay(750); // Wait for conversion (750ms for maximum precision)
+  return (true);
+}
+
+/* 
+ *=======================================================================================================================
+ * dsmux_scratchpad() - Read the scratchpad on channel into data, false if it fails its CRC or no probe answers
+ *=======================================================================================================================
+ */
+bool dsmux_scratchpad(uint8_t channel, uint8_t *data) {
+  // Select the channel on the DS2482-800
+  if (!ds248x.selectChannel(channel)) {
+    // Handle error if channel selection fails
+    Output("DSMUX:Select CH Err");
+    return (false);
+  }
 
   // Read scratchpad
-  ds248x.OneWireReset();
+  if (!ds248x.OneWireReset()) {
+    return (false);  // No presence pulse
+  }
   ds248x.OneWireWriteByte(DS18B20_CMD_SKIP_ROM); // Skip ROM command
   ds248x.OneWireWriteByte(DS18B20_CMD_READ_SCRATCHPAD); // Read Scratchpad command
 
-  uint8_t data[9];
-  for (int i = 0; i < 9; i++) {
+  for (int i = 0; i < DS18B20_SCRATCHPAD_LEN; i++) {
     ds248x.OneWireReadByte(&data[i]);
   }
 
-  // Calculate temperature
+  // All 0x00 passes the CRC, the config byte always has its low 5 bits set
+  return ((crc8_maxim(data, DS18B20_SCRATCHPAD_LEN) == 0) && ((data[4] & 0x1F) == 0x1F));
+}
+
+/* 
+ *=======================================================================================================================
+ * dsmux_resolution() - Set the probe on channel to cf_dst_resolution bits, keeps its TH and TL
+ *=======================================================================================================================
+ */
+bool dsmux_resolution(uint8_t channel) {
+  uint8_t data[DS18B20_SCRATCHPAD_LEN];
+
+  if (!dsmux_scratchpad(channel, data)) {
+    return (false);
+  }
+  ds248x.OneWireReset();
+  ds248x.OneWireWriteByte(DS18B20_CMD_SKIP_ROM);
+  ds248x.OneWireWriteByte(DS18B20_CMD_WRITE_SCRATCHPAD);
+  ds248x.OneWireWriteByte(data[2]);  // TH
+  ds248x.OneWireWriteByte(data[3]);  // TL
+  ds248x.OneWireWriteByte(((cf_dst_resolution - 9) << 5) | 0x1F);
+  return (true);
+}
+
+/* 
+ *=======================================================================================================================
+ * dsmux_readScratchpad() - Read the result of the last conversion on channel, NAN on error
+ *=======================================================================================================================
+ */
+float dsmux_readScratchpad(uint8_t channel) {
+  uint8_t data[DS18B20_SCRATCHPAD_LEN];
+  int try_count;
+
+  for (try_count=0; try_count<DS18B20_READ_TRIES; try_count++) {
+    if (dsmux_scratchpad(channel, data)) {
+      break;
+    }
+    sprintf (Buffer32Bytes, "DST%d CRC ERR", channel);
+    Output (Buffer32Bytes);
+  }
+  if (try_count == DS18B20_READ_TRIES) {
+    return NAN; // Return 'Not a Number' to indicate an error
+  }
+
+  // Probe lost power and is back at its default resolution, this conversion was not waited out
+  int bits = ((data[4] & DS18B20_CONFIG_MASK) >> 5) + 9;
+  if (bits != cf_dst_resolution) {
+    sprintf (Buffer32Bytes, "DST%d RES %d", channel, bits);
+    Output (Buffer32Bytes);
+    dsmux_resolution(channel);
+    return NAN;
+  }
+
+  // Calculate temperature, the bits below the resolution are undefined
   int16_t raw = (data[1] << 8) | data[0];
+  raw &= ~((1 << (12 - bits)) - 1);
   float celsius = (float)raw / 16.0;
 
   return (celsius);
 }
 
+/* 
+ *=======================================================================================================================
+ * dsmux_trigger() - Start conversions on all channels with a sensor, dsmux_obs_do() collects them
+ *=======================================================================================================================
+ */
+void dsmux_trigger() {
+  int n = 0;
+
+  if (DSMUX_exists) {
+    for (int channel=0; channel<DS248X_CHANNELS; channel++) {
+      if (dsmux_sensor_exists[channel] && dsmux_convert(channel)) {
+        n++;
+      }
+    }
+  }
+  if (n) {
+    dsmux_trigger_ms = millis();
+    dsmux_triggered = true;
+  }
+}
+
 /* 
  *=======================================================================================================================
  * dsmux_get_sensor_address() - 
@@ -104,16 +201,17 @@ bool dsmux_get_sensor_address(int channel, uint8_t *addr) {
  */
 void dsmux_obs_do(int &sidx) {
   if (DSMUX_exists) {
+    if (!dsmux_triggered) {
+      dsmux_trigger();
+    }
+    if (dsmux_triggered) {
+      DelaySince(dsmux_trigger_ms, dsmux_convert_ms);
+      dsmux_triggered = false;
+    }
+
     for (int channel=0; channel<DS248X_CHANNELS; channel++) {
       if (dsmux_sensor_exists[channel]) {
-        float t = dsmux_readTemperature(channel);
-        t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-
-        sprintf (Buffer32Bytes, "dst%d", channel);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = (float) t;
-        obs.sensor[sidx++].inuse = true;
+        OBS_Add (sidx, OBSREG_DST0 + channel, dsmux_readScratchpad(channel));
       }
     }
   }
@@ -128,22 +226,40 @@ void dsmux_initialize() {
   Output("DSMUX:INIT");
 
   if (ds248x.begin(&Wire, DSMUX_ADDRESS)) {
-    uint8_t addr[8];
+    uint8_t addr[DS248X_CHANNELS][8];
 
     Output ("DSMUX Channel Scan");
     DSMUX_exists = true;
     int count=0;
 
+    // 750ms halved for each bit under 12 rounded up, 94, 188, 375 or 750ms
+    int shift = 12 - cf_dst_resolution;
+    dsmux_convert_ms = (DS18B20_CONVERT_MS + (1 << shift) - 1) >> shift;
+
     for (int channel=0; channel<DS248X_CHANNELS; channel++) {
-      dsmux_sensor_exists[channel] = dsmux_get_sensor_address(channel, addr);
+      dsmux_sensor_exists[channel] = dsmux_get_sensor_address(channel, addr[channel]);
+
+      if (dsmux_sensor_exists[channel] && !dsmux_resolution(channel)) {
+        sprintf (Buffer32Bytes, "DST%d RES ERR", channel);
+        Output (Buffer32Bytes);
+      }
+    }
 
+    // Convert all, then read all
+    dsmux_trigger();
+    if (dsmux_triggered) {
+      DelaySince(dsmux_trigger_ms, dsmux_convert_ms);
+      dsmux_triggered = false;
+    }
+    for (int channel=0; channel<DS248X_CHANNELS; channel++) {
       if (dsmux_sensor_exists[channel]) {
-        float t = dsmux_readTemperature(channel);
+        float t = dsmux_readScratchpad(channel);
 
-        sprintf (Buffer32Bytes, "  dst-%d=%.2f %02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X",
+        sprintf (msgbuf, "  dst-%d=%.2f %02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X",
           channel, t,
-          addr[0],addr[1],addr[2],addr[3], addr[4],addr[5],addr[6],addr[7]);
-        Output(Buffer32Bytes);  
+          addr[channel][0],addr[channel][1],addr[channel][2],addr[channel][3], 
+          addr[channel][4],addr[channel][5],addr[channel][6],addr[channel][7]);
+        Output(msgbuf);  
         count++;
       }
     }
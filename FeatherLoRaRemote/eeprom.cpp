@@ -23,6 +23,7 @@
  */
 EEPROM_NVM eeprom;
 uint8_t *eeprom_ptr;
+EEPROM_LORA eeprom_lora;
 
 int  eeprom_address = 0x00;
 bool eeprom_valid = false;
@@ -279,6 +280,18 @@ void EEPROM_Update() {
   }
 }
 
+/* 
+ *=======================================================================================================================
+ * EEPROM_UpdateN2S() - Write eeprom with the new n2sfp. Unlike EEPROM_Update() rgts is not changed
+ *=======================================================================================================================
+ */
+void EEPROM_UpdateN2S() {
+  if (eeprom_valid) {
+    EEPROM_ChecksumUpdate();
+    eeprom_i2c.write(eeprom_address, eeprom_ptr, sizeof(eeprom));
+  }
+}
+
 /* 
  *=======================================================================================================================
  * EEPROM_Dump() - 
@@ -316,6 +329,67 @@ void EEPROM_Dump() {
   Output (Buffer32Bytes);
 }
 
+/* 
+ *=======================================================================================================================
+ * EEPROM_LoRaChecksum()
+ *=======================================================================================================================
+ */
+unsigned long EEPROM_LoRaChecksum() {
+  unsigned long checksum=EEPROM_LORA_MAGIC;
+  uint8_t *p = (uint8_t *) &eeprom_lora;
+
+  for (unsigned int i=0; i<offsetof(EEPROM_LORA, checksum); i++) {
+    checksum += p[i];
+  }
+  return (checksum);
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_LoRaRead() - Read LoRa region into eeprom_lora, return false if missing or checksum error
+ *=======================================================================================================================
+ */
+bool EEPROM_LoRaRead() {
+  if (!eeprom_exists) {
+    return (false);
+  }
+  eeprom_i2c.read(EEPROM_LORA_ADDR, (uint8_t *) &eeprom_lora, sizeof(eeprom_lora));
+  if (eeprom_lora.checksum != EEPROM_LoRaChecksum()) {
+    Output("EEPROM LORA CSE");
+    return (false);
+  }
+  return (true);
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_LoRaBlank() - After a failed EEPROM_LoRaRead(), true if the region was never written (all 0xFF or 0x00)
+ *=======================================================================================================================
+ */
+bool EEPROM_LoRaBlank() {
+  uint8_t *p = (uint8_t *) &eeprom_lora;
+
+  for (unsigned int i=1; i<sizeof(eeprom_lora); i++) {
+    if ((p[i] != p[0]) || ((p[0] != 0xFF) && (p[0] != 0x00))) {
+      return (false);
+    }
+  }
+  return (true);
+}
+
+/* 
+ *=======================================================================================================================
+ * EEPROM_LoRaUpdate() - Write eeprom_lora to LoRa region
+ *=======================================================================================================================
+ */
+void EEPROM_LoRaUpdate() {
+  if (eeprom_exists) {
+    eeprom_lora.checksum = EEPROM_LoRaChecksum();
+    eeprom_i2c.write(EEPROM_LORA_ADDR, (uint8_t *) &eeprom_lora, sizeof(eeprom_lora));
+    Output("EEPROM LORA UPDATED");
+  }
+}
+
 /* 
  *=======================================================================================================================
  * EEPROM_initialize() - 
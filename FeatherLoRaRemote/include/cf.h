@@ -33,6 +33,76 @@ lora_txpower=23
 # Valid entries are 433, 866, 915
 lora_freq=915
 
+# Transmit duty cycle limit over a rolling hour in tenths of a percent, 0 = no limit
+# 10 = 1% (866 MHz), 100 = 10%. INFO is dropped first, a quarter is kept for observations
+lora_dutycycle=0
+
+# Listen for a gateway ACK after each transmit, 0 = no, 1 = yes. Gateway must support it
+lora_ack=0
+
+# Adaptive Data Rate, step Spreading Factor 7-12 from the ACK link margin. Needs lora_ack=1
+lora_adr=0
+
+# Reliable mode, resend a message not acked up to this many times (0-5). Needs lora_ack=1
+lora_retries=0
+
+# Listen before talk, check the channel is clear (CAD) and back off randomly if not, 0 = no, 1 = yes
+lora_lbt=0
+
+# Frequency hopping, lora_freq=915 only. Channel n is lora_chbase + n * lora_chspace kHz. 0 = off, max 16
+# Channel follows lora_unitid and the Transmit Counter, each retry moves up one channel, the gateway has to hop with us
+# A channel rests 50 times the airtime after use, 400 ms in 20 s. Messages over 400 ms are dropped, lora_adr stops at SF7
+lora_channels=0
+lora_chbase=903900
+lora_chspace=200
+
+# Gateway time beacons in the ACKs keep the RTC, needs lora_ack=1. 0 = off
+# N = step the RTC when it is N or more seconds off (min 2). The GPS is then not powered up for time
+# With no valid RTC the gateway is asked for the time
+lora_timesync=0
+
+# Need to Send queue, observation messages not sent (or not acked with lora_ack=1) are kept on SD
+# and this many are sent again after each observation that gets through. 0 = off, max 10
+n2s_rate=0
+
+# Cipher, 0 = AES-128-CBC (padded to 16 bytes), 1 = AES-128-CTR (no padding, 4 byte nonce). Gateway must match
+lora_cipher=0
+
+# Message check bytes, 0 = 16 bit sum, 1 = CRC-16/CCITT-FALSE. Gateway must match
+lora_crc=0
+
+# Transmit slots, spread units across the observation period. 0 = off, send right after the observation
+# Unit sends lora_unitid % lora_slots * lora_slotwidth seconds after the period boundary
+# lora_slots * lora_slotwidth must leave 60 seconds before the next period, else slots are turned off
+lora_slots=0
+lora_slotwidth=10
+
+# Relay, forward frames from neighbors out of gateway range. 0 = off
+# N = seconds to listen after each observation, stops at our own slot. Give neighbors earlier slots
+# Frames heard are sent after our own observation, up to 3 hops. Neighbors get no ACK through a relay
+# Without lora_slots our own observation waits the full N seconds of listening before it is sent
+lora_relay=0
+
+# Observation message format
+# 0 = JSON (LR)
+# 1 = Binary (LB) - Tag index, scaled values and epoch time
+# 2 = JSON Fragmented (LF) - Header sent once, INFO also
+# 3 = Binary Delta (LD) - As LB, values are changes from the last observation delivered. Best with lora_ack=1
+obs_format=0
+
+# obs_format=3, send a full (keyframe) observation after this many. 1 to 255
+obs_keyframe=12
+
+# Observations per transmission, for slow changing sensors. 0 or 1 = send every observation
+# N = hold N observations and send them together as one delta encoded binary message (LM) every N periods
+# Used in place of obs_format for observations. Max 12
+obs_batch=0
+
+# Daily INFO, 0 = always the full INFO
+# 1 = full INFO only when the configuration, devices or sensors change, or the gateway asks for it (lora_ack=1)
+#     Otherwise only the fingerprint, battery, health, GPS and LoRa stats are sent
+info_compact=0
+
 #################################################
 # General Configurations Settings
 #################################################
@@ -72,6 +142,10 @@ op2=0
 # Distance sensor baseline. If positive, distance = baseline - ds_median
 ds_baseline=0
 
+# DSMUX DS18B20 probe resolution in bits, 9 to 12
+# 9=0.5C 94ms 10=0.25C 188ms 11=0.125C 375ms 12=0.0625C 750ms
+dst_resolution=12
+
 # elevation used for MSLP
 elevation=0
 
@@ -118,6 +192,25 @@ extern int cf_lora_unitid;
 extern int cf_lora_gwid;
 extern int cf_lora_txpower;
 extern int cf_lora_freq;
+extern int cf_lora_dutycycle;
+extern int cf_lora_ack;
+extern int cf_lora_adr;
+extern int cf_lora_retries;
+extern int cf_lora_lbt;
+extern int cf_lora_cipher;
+extern int cf_lora_crc;
+extern int cf_n2s_rate;
+extern int cf_lora_timesync;
+extern int cf_lora_slots;
+extern int cf_lora_slotwidth;
+extern int cf_lora_relay;
+extern int cf_lora_channels;
+extern long cf_lora_chbase;
+extern int cf_lora_chspace;
+extern int cf_obs_format;
+extern int cf_obs_batch;
+extern int cf_obs_keyframe;
+extern int cf_info_compact;
 
 // Instruments
 extern int cf_nowind;
@@ -127,6 +220,7 @@ extern int cf_op2;
 extern int cf_op3;
 extern int cf_op4;
 extern int cf_ds_baseline;
+extern int cf_dst_resolution;
 extern int cf_elevation;
 
 // System Timing
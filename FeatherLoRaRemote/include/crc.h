@@ -0,0 +1,30 @@
+/*
+ * ======================================================================================================================
+ *  crc.h - Frame Integrity Definations
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  CRC-16/CCITT-FALSE - Polynomial 0x1021, init 0xFFFF, no reflection, no final xor
+ *    Check value, CRC of the 9 bytes "123456789" = 0x29B1
+ *    Table driven, one lookup per byte
+ * ======================================================================================================================
+ */
+#define CRC16_INIT  0xFFFF
+
+/*
+ * ======================================================================================================================
+ *  CRC-8/MAXIM - Polynomial 0x31 reflected (0x8C), init 0x00, Dallas 1-Wire ROM and scratchpad CRC
+ *    Check value, CRC of the 9 bytes "123456789" = 0xA1
+ *    Bitwise, the scratchpad is only 8 bytes
+ * ======================================================================================================================
+ */
+
+// Extern variables
+extern const uint16_t crc16_table[256];
+
+// Function prototypes
+uint16_t crc16_update(uint16_t crc, const uint8_t *buf, int len);
+uint16_t crc16(const uint8_t *buf, int len);
+uint8_t crc8_maxim(const uint8_t *buf, int len);
@@ -45,12 +45,29 @@
 #define DS18B20_CMD_SKIP_ROM 0xCC
 #define DS18B20_CMD_CONVERT_T 0x44
 #define DS18B20_CMD_READ_SCRATCHPAD 0xBE
+#define DS18B20_CMD_WRITE_SCRATCHPAD 0x4E
+#define DS18B20_SCRATCHPAD_LEN 9  // Temp LSB, MSB, TH, TL, Config, 3 reserved, CRC-8/MAXIM of the 8 before
+#define DS18B20_CONFIG_MASK 0x60  // Config byte resolution bits R1 R0, 9 to 12 bits = 0 to 3
+#define DS18B20_READ_TRIES 2      // Scratchpad reads before a CRC failure is an error
+#define DS18B20_CONVERT_MS 750    // 12 bit conversion, halves for each bit less
+
+/*
+ * dsmux_trigger() starts a conversion on every channel, the probes convert at the same time and
+ * dsmux_obs_do() reads them all after one wait, not one wait per channel. Probes need VDD wired,
+ * a parasite powered probe loses its power when the DS2482 moves on to the next channel.
+ *
+ * dst_resolution=9-12 in CONFIG.TXT sets the probes at boot. The wait is 94, 188, 375 or 750ms.
+ * A probe that has lost power comes back at 12 bits, the read sees the config byte differ, sets it
+ * again and reports that obs as an error, as its conversion was cut short.
+ */
 
 // Extern variables
 extern  Adafruit_DS248x ds248x;
 extern bool DSMUX_exists;
 extern bool dsmux_sensor_exists[DS248X_CHANNELS];
+extern unsigned long dsmux_convert_ms;
 
 // Function prototypes
 void dsmux_initialize();
+void dsmux_trigger();
 void dsmux_obs_do(int &sidx);
\ No newline at end of file
@@ -21,8 +21,24 @@ typedef struct {
     unsigned long checksum;
 } EEPROM_NVM;
 
+/*
+ * ======================================================================================================================
+ *  EEPROM LoRa - LoRa link settings kept across reboots. Own region and checksum so EEPROM_NVM is not changed
+ * ======================================================================================================================
+ */
+#define EEPROM_LORA_ADDR  0x40
+#define EEPROM_LORA_MAGIC 0x4C52   // "LR"
+
+typedef struct {
+    uint8_t  sf;         // Spreading Factor chosen by ADR
+    uint8_t  noctr;      // Region was lost and bootcnt with it, CTR nonces could repeat, CBC only
+    uint16_t bootcnt;    // CTR nonce boot count
+    unsigned long checksum;
+} EEPROM_LORA;
+
 // Extern variables
 extern EEPROM_NVM eeprom;
+extern EEPROM_LORA eeprom_lora;
 extern bool eeprom_valid;
 extern bool eeprom_exists;
 
@@ -36,5 +52,9 @@ void EEPROM_Validate();
 void EEPROM_UpdateRainTotals(float rgt1, float rgt2);
 void EEPROM_SaveUnreportedRain();
 void EEPROM_Update();
+void EEPROM_UpdateN2S();
 void EEPROM_Dump();
+bool EEPROM_LoRaRead();
+bool EEPROM_LoRaBlank();
+void EEPROM_LoRaUpdate();
 void EEPROM_initialize();
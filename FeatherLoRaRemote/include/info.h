@@ -4,5 +4,44 @@
  * ======================================================================================================================
  */
 
+/*
+ * ======================================================================================================================
+ *  INFO Fingerprint - info_compact=1 in CONFIG.TXT
+ *
+ *  "ifp" is a FNV-1a 32 bit hash, 8 hex digits, over what rarely changes: versioninfo, every setting that
+ *  changes what is sent or how the gateway decodes it (not the AES key or IV), the discovered devices list
+ *  and the sensors lists. It is sent in every INFO. A new cf_ setting of that kind has to be added to it.
+ *
+ *  The full INFO is sent at boot, when the fingerprint differs from the last full INFO delivered, and when the
+ *  gateway sets LORA_ACK_INFO in an ACK (needs lora_ack=1). Otherwise the INFO is only ifp, bv, hth, t2nt,
+ *  gps and the LoRa stats, in as few IF messages as they fit. INFO.TXT on the SD card is always the full INFO.
+ *  Delivered is every IF or LF message of it sent, acked with lora_ack=1, none left in the Transmit Queue.
+ *
+ *  Parts - The full INFO is built once, the parts sent over LoRa point into it and are not copied. Parts
+ *  share an IF message while they fit. A part too long for one is split before a JSON member, or between
+ *  the items of a sensors list, and goes on in the next message. A sensors list is sent as "sensors",
+ *  each list in its own message so the key does not repeat within one.
+ * ======================================================================================================================
+ */
+#define INFO_FNV_INIT   2166136261UL
+#define INFO_FNV_PRIME  16777619UL
+#define INFO_PARTS      9     // base, devs + gps, sensors x 3, ifp, LoRa stats, hopping or relay stats
+#define INFO_SENSOR_LISTS 3
+#define INFO_SENSORS    ",\"sensors\":\""
+
+typedef struct {
+  const char *s;      // Not null terminated, most point into the full INFO
+  int len;
+  bool list;          // Sensors list, sent as "sensors"
+} INFO_PART;
+
+// Extern variables
+extern uint32_t INFO_Fingerprint;
+
 // Function prototypes
-void INFO_Do();
+uint32_t INFO_FNV1a(uint32_t h, const char *s, int len);
+int INFO_PartAdd(INFO_PART *parts, int nparts, const char *s, int len, bool list);
+int INFO_Split(const char *s, int len, int room, bool list);
+int INFO_Pack(MSGW *mw, INFO_PART *parts, int nparts, int &p, int &off);
+bool INFO_SendParts(const char *header, INFO_PART *parts, int nparts);
+bool INFO_Do();
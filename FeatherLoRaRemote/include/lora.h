@@ -5,17 +5,324 @@
  */
 #define LORA_SS   8
 #define LORA_INT  3     // Feather 32u4 LoRa used pin 7
+#define LORA_MAX_MSGLEN 239  // Max length of message is 255, leave AES padding headroom
+
+/*
+ * ======================================================================================================================
+ *  Fragmented Message - Message Type LF
+ *
+ *  Sent when obs_format=2 in CONFIG.TXT. The full JSON observation (or INFO) with its header
+ *  (at, devid, mtype) is sent once and split across as many LoRa messages as needed.
+ *
+ *  NCSLF,[unitid],[counter],[msgid],[fragidx],[fragcnt],[chunk]
+ *
+ *    msgid     0-255, rolls over. Same for all fragments of a message
+ *    fragidx   0 to fragcnt-1
+ *    fragcnt   Number of fragments in the message
+ *    chunk     Next LORA_FRAG_SPACE (or fewer) bytes of the message
+ *
+ *  Reassembly - Keyed on unitid and msgid. Place each chunk at fragidx. When all fragcnt
+ *  fragments have arrived concatenate the chunks in fragidx order, the result is the JSON
+ *  message. Drop the partial message if a fragment with a new msgid arrives from the unit
+ *  or it is not complete within a couple of observation periods.
+ * ======================================================================================================================
+ */
+#define LORA_FRAG_SPACE 200  // Max chunk bytes per LF message. LORA_MAX_MSGLEN less LF header
+#define LORA_FRAG_MAX   16   // Max fragments per message
+
+/*
+ * ======================================================================================================================
+ *  Duty Cycle Budget - lora_dutycycle in CONFIG.TXT, tenths of a percent
+ *
+ *  Airtime of each transmit is added to the current 5 minute bucket. The sum of the last
+ *  12 buckets is the airtime used over the rolling hour. A transmit is dropped when it would
+ *  take the hour over budget. Each priority class below observations keeps prio/8 of the budget
+ *  for the classes above it, INFO is dropped once it would eat into the last quarter.
+ * ======================================================================================================================
+ */
+#define LORA_PRIO_HIGH      0        // Current observation
+#define LORA_PRIO_EVENT     1        // Events, time requests
+#define LORA_PRIO_LOW       2        // INFO, relayed frames
+#define LORA_PRIO_N2S       3        // Need to Send backlog
+#define LORA_DC_BUCKETS     12
+#define LORA_DC_BUCKET_SECS 300      // 12 x 5 minutes = 1 hour
+
+/*
+ * ======================================================================================================================
+ *  Gateway ACK - lora_ack=1 in CONFIG.TXT
+ *
+ *  Messages are sent with LORA_FLAG_ACKREQ set in the RadioHead header flags. After each transmit
+ *  we listen LORA_ACK_TURNAROUND ms plus the ACK airtime for the gateway reply. The ACK is one
+ *  AES-128-CBC block, no padding, same key and IV as our messages, sent to our unitid.
+ *
+ *    Byte 0-1    'A' 'K'
+ *    Byte 2      unitid being acked
+ *    Byte 3-4    Transmit Counter being acked, low 16 bits, little endian
+ *    Byte 5-6    RSSI the gateway received us at, int16 dBm, little endian
+ *    Byte 7      SNR the gateway received us at, int8 dB
+ *    Byte 8      Flags, LORA_ACK_INFO = send the full INFO, See info.h
+ *                       LORA_ACK_TIME = bytes 9-14 hold the gateway time
+ *    Byte 9-12   Gateway time it received the end of the message being acked, unix epoch, little endian
+ *    Byte 13-14  Milliseconds part of that time 0-999, little endian
+ *    Byte 15     Reserved, set to 0
+ *
+ *  Adaptive Data Rate - lora_adr=1, needs lora_ack=1
+ *
+ *  Link margin is the gateway SNR less the demodulation floor of our Spreading Factor, less
+ *  LORA_ADR_INSTALL margin. SF steps up (slower) on a negative margin or LORA_ADR_MISSES ACKs
+ *  missed in a row. SF steps down (faster) when the last LORA_ADR_HISTORY ACKs all had
+ *  LORA_ADR_DOWN or more margin. After LORA_ADR_FALLBACK ACKs missed in a row at the top SF it goes
+ *  back to the SF it started at. The SF is kept in EEPROM and restored at boot, but only after an
+ *  ACK, steps up from missed ACKs alone are not kept so a gateway outage does not leave it at SF12.
+ * ======================================================================================================================
+ */
+#define LORA_FLAG_ACKREQ    0x04     // RadioHead header flag, application bits are 0x0F
+#define LORA_ACK_INFO       0x01     // ACK flags byte, gateway wants the full INFO
+#define LORA_ACK_TIME       0x02     // ACK flags byte, gateway time is in the ACK
+#define LORA_FLAG_N2S       0x08     // Message is from the Need to Send queue, same value as SSB_FROM_N2S
+#define LORA_ACK_LEN        16
+#define LORA_ACK_TURNAROUND 250      // ms for the gateway to decrypt and reply
+#define LORA_SF_MIN         7
+#define LORA_SF_MAX         12
+#define LORA_ADR_INSTALL    100      // Tenths of dB margin kept for fading
+#define LORA_ADR_DOWN       60       // Tenths of dB margin needed on every ACK to step SF down
+#define LORA_ADR_HISTORY    4
+#define LORA_ADR_MISSES     3
+#define LORA_ADR_FALLBACK   12       // ACKs missed in a row at the top SF
+
+/*
+ * ======================================================================================================================
+ *  Time Beacon - lora_timesync=N in CONFIG.TXT, needs lora_ack=1
+ *
+ *  The gateway puts its time into the ACK, taken when it received the end of our message, which is
+ *  when our TxDone was. Gateway time now is that plus the ms since our TxDone, so the airtime of the
+ *  ACK and the gateway turnaround do not add error. The offset to the RTC is kept in ms, the RTC only
+ *  has whole seconds so its time is taken as the middle of the current second.
+ *
+ *  After LORA_TIME_SAMPLES offsets, if the median is N or more seconds the RTC is stepped by it.
+ *  The median drops the odd beacon delayed at the gateway. With a beacon in the last
+ *  RTC_UPDATE_INTERVAL hours the GPS is not powered up to refresh the RTC.
+ *
+ *  With no valid RTC, a TQ message (no payload) is sent every LORA_TIME_REQUEST ms and the first
+ *  beacon in the ACK sets the RTC. So does a beacon LORA_TIME_FAR or more seconds from the RTC.
+ * ======================================================================================================================
+ */
+#define LORA_TIME_SAMPLES   5
+#define LORA_TIME_MIN       2        // Min lora_timesync seconds, the RTC has 1 second resolution
+#define LORA_TIME_REQUEST   60000    // ms between TQ messages when the RTC is not valid
+#define LORA_TIME_FAR       3600     // Seconds, RTC this far off is set from one beacon
+
+/*
+ * ======================================================================================================================
+ *  Reliable Mode - lora_retries=N in CONFIG.TXT, needs lora_ack=1
+ *
+ *  A message not acked is sent again up to N more times. Before retry n we wait
+ *  LORA_RETRY_BASE * 2^(n-1) ms, capped at LORA_RETRY_CAP, of which a random half is jitter.
+ *  Each retry is checked against the duty cycle budget.
+ * ======================================================================================================================
+ */
+#define LORA_RETRY_MAX      5
+#define LORA_RETRY_BASE     1000     // ms
+#define LORA_RETRY_CAP      8000     // ms
+
+/*
+ * ======================================================================================================================
+ *  Listen Before Talk - lora_lbt=1 in CONFIG.TXT
+ *
+ *  Before each transmit RH_RF95 Channel Activity Detection checks for a preamble on the channel.
+ *  If busy, wait a random LORA_LBT_MIN to LORA_LBT_MAX ms, the upper bound doubles on each busy.
+ *  After LORA_LBT_TRIES busy results we send anyway rather than lose the observation.
+ * ======================================================================================================================
+ */
+#define LORA_LBT_TRIES      5
+#define LORA_LBT_MIN        50       // ms
+#define LORA_LBT_MAX        500      // ms, first window
+
+/*
+ * ======================================================================================================================
+ *  Transmit Pipeline
+ *
+ *  SendLoraAESMsg() returns as soon as the message is handed to the radio. The next message is
+ *  built and encrypted while this one is on air. Before the next transmit we idle in low power
+ *  until TxDone, then for a spacing equal to the last airtime, limited to LORA_IFS_MIN to
+ *  LORA_IFS_MAX ms, giving the gateway time to decrypt and forward. LoRaDisableSPI() and
+ *  LoRaSleep() wait for the message on air before the SPI bus is used or the radio sleeps.
+ * ======================================================================================================================
+ */
+#define LORA_IFS_MIN        50       // ms
+#define LORA_IFS_MAX        500      // ms, was a fixed delay(500) between messages
+
+/*
+ * ======================================================================================================================
+ *  Cipher - lora_cipher in CONFIG.TXT
+ *
+ *  0 CBC  AES-128-CBC, PKCS#7 padding to a 16 byte multiple. IV is aes_myiv repeated twice.
+ *  1 CTR  AES-128-CTR, no padding. Sent as [nonce 4 bytes][cipher, same length as the message]
+ *           Nonce     boot count u16, Transmit Counter low 16 bits u16, little endian, in the clear
+ *           Counter   aes_myiv 8 bytes | nonce 4 bytes | block number u32 big endian from 0
+ *         Keystream block n = AES(key, counter n), cipher = message XOR keystream.
+ *         Boot count is kept in EEPROM and bumped each boot and each time a frame header takes the
+ *         first Transmit Counter of a new 65536 block. The boot count is taken with the counter when
+ *         the header is built and kept with a queued message, so a frame dropped before encryption or
+ *         sent later from the Transmit Queue does not move a nonce into another epoch.
+ *         CTR falls back to CBC if there is no EEPROM, if the EEPROM LoRa region was lost (the boot
+ *         count is unknown, this stays so across reboots) or when the boot count runs out.
+ *
+ *         Matches standard AES-CTR with a 128 bit big endian counter, e.g. openssl enc -aes-128-ctr
+ *
+ *         Test vector: aes_pkey 0123456789ABCDEF, aes_myiv 1234567, boot count 3, Transmit Counter 5,
+ *         message bytes 0x00 to 0x27 (40 bytes). Counter block 0 = 87d61200000000000300050000000000
+ *           03000500 024ae5e0db8a4475d39396b99d8956e1322e48cf4c8117876e7ad0db4c7e13665389a98339037cf7
+ *
+ *  ACKs are a single CBC block in either mode.
+ * ======================================================================================================================
+ */
+#define LORA_CIPHER_CBC     0
+#define LORA_CIPHER_CTR     1
+#define LORA_CTR_NONCE      4
+
+/*
+ * ======================================================================================================================
+ *  Relay - lora_relay=N in CONFIG.TXT, seconds to listen each observation period, 0 = off
+ *
+ *  After taking its observation a relay listens N seconds, or up to its own slot if sooner, for
+ *  neighbors sending to the gateway. Neighbors out of gateway range are given earlier slots than
+ *  the relay. Frames heard are queued and sent after the relay's own observation, in its slot.
+ *
+ *  The frame is sent as received, the relay does not decrypt it. In the RadioHead header the from
+ *  is left as the neighbor's unitid, the id is the low 8 bits of the neighbor's Transmit Counter
+ *  (every unit sets it), and the hop count in the flags goes up by one. LORA_FLAG_ACKREQ is cleared,
+ *  the gateway ACK would not reach the neighbor. Frames with LORA_RELAY_HOPS hops are not forwarded.
+ *
+ *  Duplicates, a neighbor's retries or the same frame from another relay, are dropped by from and
+ *  id over the last LORA_RELAY_SEEN frames. At most LORA_RELAY_QUEUE frames are held, more are dropped.
+ *  Forwards are charged to the relay's duty cycle budget at low priority, its own observations
+ *  keep the reserve. Receive time and forward airtime are in INFO "lrly" for the energy cost.
+ * ======================================================================================================================
+ */
+#define LORA_FLAG_HOPS      0x03     // RadioHead header flags, times the frame was relayed
+#define LORA_RELAY_HOPS     3
+#define LORA_RELAY_QUEUE    4        // Frames, RH_RF95_MAX_MESSAGE_LEN bytes each
+#define LORA_RELAY_SEEN     16
+
+/*
+ * ======================================================================================================================
+ *  Frequency Hopping - lora_channels=N in CONFIG.TXT, 915 MHz only
+ *
+ *  Channel n is lora_chbase + n * lora_chspace kHz, n = 0 to N-1. A message and its ACK are on the
+ *  channel picked from the unitid and the low 8 bits of the Transmit Counter, which is also the
+ *  RadioHead header id. Retry r (1 to lora_retries) and its ACK move up r channels. The gateway works
+ *  out the same channel with
+ *
+ *    x = (unitid << 8) | (counter & 0xFF)
+ *    x ^= x >> 16;  x *= 0x7FEB352D;  x ^= x >> 15;  x *= 0x846CA68B;  x ^= x >> 16;   (uint32 math)
+ *    channel = ((x % N) + r) % N                                                        (r = 0 first send)
+ *
+ *    Test vector: unitid 2, N 8, counter 0 to 7 gives channels 0 1 4 4 6 6 6 0
+ *
+ *  Dwell time - A message over LORA_DWELL_MAX ms is dropped. After each transmit the channel rests for
+ *  LORA_DWELL_WINDOW / LORA_DWELL_MAX times the airtime, so no channel is used more than LORA_DWELL_MAX
+ *  ms in any LORA_DWELL_WINDOW ms. A message whose channel is resting waits for it in low power. With
+ *  N of 2 or more a retry is on another channel and does not wait out the rest of the one just used.
+ *  Full frames fit at SF7 (about 385 ms) but not at SF8, so lora_adr stops at the highest SF a full
+ *  frame fits. An N2S record that could never fit is skipped, not left at the head of the queue.
+ *  lora_relay listens on one channel, it is turned off when hopping.
+ * ======================================================================================================================
+ */
+#define LORA_CH_MAX         16
+#define LORA_DWELL_MAX      400      // ms
+#define LORA_DWELL_WINDOW   20000    // ms
+
+/*
+ * ======================================================================================================================
+ *  Transmit Queue - Priority classes in front of SendLoraAESMsg()
+ *
+ *  Current observations are never queued. A message of a lower class is deferred when the duty cycle
+ *  left for its class is too short, and EVENT and below are deferred while an observation waits for
+ *  its slot, so an INFO burst does not push the observation out of its slot. Deferred messages are
+ *  held in RAM, LORA_TXQ_LEN of them, and sent highest class first after the next observation. When
+ *  full a message displaces the newest of a lower class, else it is dropped. Backlog is not held,
+ *  it stays in N2S on the SD card. INFO "ltxq" has the worst ms an observation waited to go on air.
+ *  A message of several frames, LF fragments or the IF messages of an INFO, is not queued. It is sent
+ *  whole when the budget covers all its frames, else it is held back whole and not counted as sent,
+ *  LoRaTxHeld is set and its sender tries again after the observation, INFO on the next wake.
+ * ======================================================================================================================
+ */
+#define LORA_TXQ_LEN        4
 
 // Extern variables
 extern uint8_t  AES_KEY[16];
 extern unsigned long long int AES_MYIV;
 extern bool LORA_exists;
 extern unsigned int SendMsgCount;
+extern uint8_t  LoRaSF;
+extern uint32_t LoRaBW;
+extern uint8_t  LoRaCR;
+extern uint16_t LoRaPreamble;
+extern unsigned int LoRaDCDrops;
+extern int LoRaAckRssi;
+extern int LoRaAckSnr;
+extern unsigned int LoRaAckMissed;
+extern bool LoRaInfoRequest;
+extern unsigned long LoRaTimeLast;
+extern int LoRaTimeAdjusts;
+extern unsigned int LoRaAcked;
+extern unsigned int LoRaRetries;
+extern unsigned int LoRaLost;
+extern unsigned int LoRaLBTBusy;
+extern unsigned long LoRaLBTWait;
+extern unsigned int LoRaLBTForced;
+extern unsigned long LoRaTxIdle;
+extern unsigned int LoRaRelayHeard;
+extern unsigned int LoRaRelayForwarded;
+extern unsigned int LoRaRelayDups;
+extern unsigned int LoRaRelayDrops;
+extern unsigned long LoRaRelayListenTime;
+extern unsigned long LoRaRelayAirtime;
+extern unsigned int LoRaChTx[LORA_CH_MAX];
+extern unsigned long LoRaHopWait;
+extern unsigned int LoRaDwellDrops;
+extern uint8_t LoRaSFMax;
+extern bool LoRaObsWaiting;
+extern unsigned int LoRaTxQDeferred;
+extern unsigned int LoRaTxQDrops;
+extern bool LoRaTxWhole;
+extern bool LoRaTxHeld;
+extern unsigned long LoRaObsLatencyMax;
 
 // Function prototypes
+void LoRaTxWait();
+void LoRaIdleWait(unsigned long ms);
 void LoRaDisableSPI();
 void LoRaSleep();
-void SendLoraAESMsg (int bits,char *msg, int msgLength);
-void SendLoRaMessage(char *ops, const char *mtype);
+unsigned long LoRaAirtimeSF(int len, uint8_t sf);
+unsigned long LoRaAirtime(int len);
+int LoRaCipherLen(int len);
+unsigned long LoRaMsgAirtime(int len);
+bool LoRaFrameFits(int len);
+void LoRaSetSF(uint8_t sf);
+bool LoRaAckWait();
+void LoRaTimeBeacon(uint32_t gwsec, uint16_t gwms);
+bool LoRaTimeSynced();
+bool LoRaTimeRequest();
+void LoRaADR(bool acked);
+unsigned long LoRaDCBudget();
+unsigned long LoRaDCUsed(uint32_t t);
+bool LoRaDCCheck(uint32_t t, unsigned long airtime, int prio);
+void LoRaDCAdd(uint32_t t, unsigned long airtime);
+bool SendLoraAESMsg (char *msg, int msgLength, int prio);
+bool LoRaTxDefer(int prio, int len);
+bool LoRaTxDeferAirtime(int prio, unsigned long airtime);
+int LoRaFrameHeader(MSGW *w, const char *mtype);
+bool LoRaFrameSend(MSGW *w, int prio);
+bool LoRaTextSend(MSGW *w, int prio);
+bool SendLoRaMessage(const char *ops, const char *mtype);
+bool SendLoRaFrame(const byte *payload, int len, const char *mtype);
+bool SendLoRaN2S(const byte *payload, int len, const char *mtype);
+bool SendLoRaFragmented(const char *msg, int len, int prio);
+int LoRaHopChannel(uint8_t unitid, uint8_t id);
+void LoRaTxQueueFlush();
+void LoRaRelayListen(unsigned long ms);
+void LoRaRelayForward();
 bool lora_cf_validate();
 void lora_initialize();
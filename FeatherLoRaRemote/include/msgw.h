@@ -0,0 +1,42 @@
+/*
+ * ======================================================================================================================
+ *  msgw.h - Message Writer Definations
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Message Writer - Bounded append into a caller's buffer
+ *
+ *  The writer keeps the cursor, so appends do not rescan the buffer with strlen(). Text stays null
+ *  terminated, one byte of the buffer is kept for it. A write that does not fit is cut short and sets
+ *  overflow, the buffer is never written past its size. Check overflow once when the message is done.
+ * ======================================================================================================================
+ */
+typedef struct {
+  char *buf;          // Start of the message
+  int   size;         // Bytes in buf
+  int   len;          // Bytes written, where the next write goes
+  bool  overflow;     // A write did not fit
+} MSGW;
+
+/*
+ * ======================================================================================================================
+ *  Fixed Point Formatter - MSGW_Fmt() writes v with dp decimals, as "%.*f" would, without printf
+ *
+ *  v is taken apart into its 24 bit mantissa and exponent and scaled by 10^dp as a 64 bit integer, so
+ *  there is no float math. Rounding is to nearest, an exact half goes to even, the same as newlib printf.
+ *  The sign comes from the sign bit, so -999.9 is "-999.9" and -0.04 with 1 decimal is "-0.0" as printf.
+ *  NaN, Inf, |v| >= 1e9 or dp > 6 are handed to snprintf.
+ * ======================================================================================================================
+ */
+#define MSGW_FMT_LEN  20   // Largest MSGW_Fmt() result with null, "-999999999.999999"
+
+// Function prototypes
+void MSGW_Init(MSGW *w, char *buf, int size);
+void MSGW_Mem(MSGW *w, const void *data, int n);
+void MSGW_Str(MSGW *w, const char *s);
+void MSGW_Char(MSGW *w, char c);
+void MSGW_Printf(MSGW *w, const char *fmt, ...);
+char *MSGW_Fmt(char *out, float v, int dp);
+void MSGW_Fixed(MSGW *w, float v, int dp);
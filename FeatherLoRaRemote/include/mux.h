@@ -48,6 +48,7 @@ extern const char *sensor_type[];
 // Function prototypes
 void mux_deselect_all();
 void mux_channel_set(uint8_t channel);
+void mux_trigger();
 void mux_obs_do(int &sidx);
 void mux_scan();
 void mux_initialize();
@@ -9,7 +9,13 @@
 #define MAX_SENSORS          64
 #define LORA_PAYLOAD         222
 #define OBS_HEADER           110
-#define OBS_SPACE            112
+#define OBS_LORA_HEADER      21   // NCSLR,[len 3],[len 10], Largest LoRa header before the JSON
+#define OBS_SLOT_EARLY       60   // Seconds, an observation this close before a period boundary belongs to it
+
+#define OBS_FORMAT_JSON      0    // Message Type LR - Header repeated in each LoRa message
+#define OBS_FORMAT_BINARY    1    // Message Type LB - See obsbin.h
+#define OBS_FORMAT_FRAG      2    // Message Type LF - Full JSON sent once in fragments, See lora.h
+#define OBS_FORMAT_DELTA     3    // Message Type LD - LB with deltas against the last delivered, See obsbin.h
 
 typedef enum {
   F_OBS, 
@@ -17,14 +23,22 @@ typedef enum {
   U_OBS
 } OBS_TYPE;
 
-typedef struct {
-  char          id[12];
-  int           type;
-  float         f_obs;
-  int           i_obs;
-  unsigned long u_obs;
-  bool          inuse;
+/*
+ * SENSOR is packed to 6 bytes, the tag string lives in flash in obs_registry[]. With the old char id[12] and
+ * separate float, int and unsigned long slots it was 32 bytes, 2048 bytes of RAM for MAX_SENSORS, now 384.
+ * U_OBS values are stored in i_obs and printed with %u. Members are only read and written by value, never
+ * through a pointer, as the union is not 4 byte aligned and the M0 faults on unaligned word access.
+ */
+typedef struct __attribute__((packed)) {
+  uint8_t       tag;                  // Row in obs_registry[], See obsreg.h
+  uint8_t       type:7;               // OBS_TYPE
+  uint8_t       inuse:1;
+  union {
+    float       f_obs;
+    int         i_obs;
+  };
 } SENSOR;
+static_assert(sizeof(SENSOR) == 6, "SENSOR is not packed");
 
 typedef struct {
   bool            inuse;                // Set to true when an observation is stored here         
@@ -38,6 +52,17 @@ extern float bmx_1_pressure;
 
 // Function prototypes
 void OBS_Clear();
+void OBS_RamReport();
+int OBS_Pack(const uint8_t *len, uint8_t *pkt, int n, int space);
+int32_t OBS_DeltaBase(uint8_t tag);
+int OBS_BinHeader(byte *buf, bool keyframe);
+bool OBS_BatchFlush();
+bool OBS_Batch(time_t ts, const uint8_t *tag, const int32_t *val, int n);
 void OBS_Send();
+float OBS_Add(int &sidx, int reg, float f);
+void OBS_AddInt(int &sidx, int reg, int i);
 void OBS_Take();
+void OBS_SendNow();
 void OBS_Do();
+int OBS_SecondsToSend();
+void OBS_SendPending();
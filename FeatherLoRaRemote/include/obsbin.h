@@ -0,0 +1,92 @@
+/*
+ * ======================================================================================================================
+ *  obsbin.h - Binary Observation Frame Definations
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Binary Observation Frame - Message Type LB
+ *
+ *  Sent in place of the JSON LR message when obs_format=1 in CONFIG.TXT. The SD card log stays JSON.
+ *
+ *  NCSLB,[unitid],[counter],[payload]
+ *
+ *  Payload, multi byte integers are little endian
+ *    Byte 0      Version (OBSBIN_VERSION)
+ *    Byte 1-4    Observation time, unix epoch seconds
+ *    Byte 5-12   DeviceID as 8 binary bytes  (548fa41ef43ee791 = 0x54 0x8f ... 0x91)
+ *    Byte 13-N   Sensor records, repeated until end of payload
+ *                  1 byte   Tag index into obs_registry[], See obsreg.h
+ *                  1-5 byte Zig-zag varint of the value scaled by 10^decimals of the tag
+ *
+ *  Zig-zag maps signed to unsigned (0,-1,1,-2,2 -> 0,1,2,3,4) so small negative values stay small.
+ *  Varint is 7 bits per byte, low bits first, high bit set when more bytes follow.
+ *
+ *  Example: "bt1":22.5 -> tag 21, scaled 225, zig-zag 450 -> 0x15 0xC2 0x03
+ *
+ *  If the records do not fit in one LoRa message, the remaining records are sent in another
+ *  LB message with the same header. Each message can be decoded on its own.
+ *
+ *  The obs_registry[] table is shared with the receiving side. Only append to the end of it.
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Delta Observation Frame - Message Type LD
+ *
+ *  Sent in place of LB when obs_format=3 in CONFIG.TXT.
+ *
+ *  NCSLD,[unitid],[counter],[payload]
+ *
+ *  Payload
+ *    Byte 0-12   Header as LB
+ *    Byte 13-    Zig-zag varint of baseline age, seconds from the baseline observation time to this one.
+ *                0 = keyframe, values are not deltas
+ *    Then        Sensor records as LB, except the value is the scaled value less the scaled value of
+ *                the same tag in the baseline observation. Tag not in the baseline, less 0.
+ *
+ *  The baseline is the last observation all of whose LD messages were sent, acked with lora_ack=1.
+ *  Without lora_ack a lost LD message can make the following deltas undecodable until the next keyframe.
+ *  A keyframe is sent at boot and when obs_keyframe observations have passed since the last delivered
+ *  keyframe. The gateway keeps decoded observations by time so a baseline can be found from its age.
+ *  Split across messages the same way as LB, each message has the same header and baseline age.
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Batched Observation Frame - Message Type LM
+ *
+ *  Sent in place of LR/LB/LF/LD when obs_batch=N (N>1) in CONFIG.TXT. Observations are held in RAM and
+ *  sent together every N observation periods. The SD card log stays JSON and is written every period.
+ *
+ *  NCSLM,[unitid],[counter],[payload]
+ *
+ *  Payload
+ *    Byte 0-12   Header as LB, time is that of the first observation in the message
+ *    Byte 13-N   Observation blocks, oldest first, repeated until end of payload
+ *                  1-5 byte Zig-zag varint of seconds since the previous block (0 for the first block)
+ *                  1 byte   Number of sensor records in this block
+ *                  Sensor records as LB, except the value is the scaled value less the scaled value
+ *                  of the same tag in the previous block. First block, or tag not in it, less 0.
+ *
+ *  If the next observation does not fit, the message is sent early and the observation starts a new
+ *  one, so each LM message can be decoded on its own. Held observations are lost from the air on a
+ *  reboot, but not from the SD log.
+ * ======================================================================================================================
+ */
+#define OBSBIN_BATCH_MAX    12        // Max obs_batch
+#define OBSBIN_KEYFRAME     12        // Default obs_keyframe
+#define OBSBIN_VERSION      1
+#define OBSBIN_HEADER       13        // Version + Epoch + DeviceID
+#define OBSBIN_SPACE        200       // Max bytes of payload per LoRa message. LORA_MAX_MSGLEN less LB header
+
+// Extern variables
+
+// Function prototypes
+int obsbin_put_varint(byte *buf, int32_t value);
+int obsbin_header(byte *buf, uint32_t epoch);
+int32_t obsbin_scale(uint8_t tidx, float f, int32_t i, bool is_float);
+int obsbin_record(byte *buf, uint8_t tidx, float f, int32_t i, bool is_float);
@@ -0,0 +1,78 @@
+/*
+ * ======================================================================================================================
+ *  obsreg.h - Sensor Registry Definations
+ * ======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Sensor Registry - One row per observation tag: tag name, type, LB scaling and QC range
+ *
+ *  The row index is the tag id kept in each SENSOR of the observation and the tag index sent in LB, LD
+ *  and LM messages, See obsbin.h. The table is shared with the receiving side. Only append to the end
+ *  of obs_registry[], and to OBSREG_ID in the same order.
+ *
+ *  Adding a sensor observation is a row here and an OBS_Add() where the sensor is read. OBS_Add() sets
+ *  the type from the row, applies the row's QC range and will not go past MAX_SENSORS.
+ * ======================================================================================================================
+ */
+#define OBSREG_UNKN         0xFF      // Tag not in obs_registry[]
+
+typedef enum {
+  OBSREG_QC_NONE,
+  OBSREG_QC_T,
+  OBSREG_QC_RH,
+  OBSREG_QC_P,
+  OBSREG_QC_VI,
+  OBSREG_QC_IR,
+  OBSREG_QC_UV,
+  OBSREG_QC_WS,
+  OBSREG_QC_WD
+} OBSREG_QC_TYPE;
+
+typedef enum {
+  OBSREG_BV,          OBSREG_HTH,         OBSREG_RG1,         OBSREG_RGT1,        OBSREG_RGP1,           //   0 -   4
+  OBSREG_RG2,         OBSREG_RGT2,        OBSREG_RGP2,        OBSREG_OP1R,        OBSREG_DS,             //   5 -   9
+  OBSREG_DSR,         OBSREG_OP2R,        OBSREG_VBV,         OBSREG_VPC,         OBSREG_OP3R,           //  10 -  14
+  OBSREG_OP4R,        OBSREG_WS,          OBSREG_WD,          OBSREG_WG,          OBSREG_WGD,            //  15 -  19
+  OBSREG_BP1,         OBSREG_BT1,         OBSREG_BH1,         OBSREG_BP2,         OBSREG_BT2,            //  20 -  24
+  OBSREG_BH2,         OBSREG_BP3,         OBSREG_BT3,         OBSREG_BP4,         OBSREG_BT4,            //  25 -  29
+  OBSREG_ST1,         OBSREG_SH1,         OBSREG_ST2,         OBSREG_SH2,         OBSREG_HDT1,           //  30 -  34
+  OBSREG_HDH1,        OBSREG_HDT2,        OBSREG_HDH2,        OBSREG_HDT3,        OBSREG_HDH3,           //  35 -  39
+  OBSREG_HDT4,        OBSREG_HDH4,        OBSREG_HH1,         OBSREG_HT1,         OBSREG_HT2,            //  40 -  44
+  OBSREG_HH2,         OBSREG_SV1,         OBSREG_SI1,         OBSREG_SU1,         OBSREG_MT1,            //  45 -  49
+  OBSREG_MT2,         OBSREG_GT1,         OBSREG_GT2,         OBSREG_PM1E10,      OBSREG_PM1E25,         //  50 -  54
+  OBSREG_PM1E100,     OBSREG_HI,          OBSREG_WBT,         OBSREG_WBGT,        OBSREG_MSLP,           //  55 -  59
+  OBSREG_TLWW,        OBSREG_TLWT,        OBSREG_TSME25,      OBSREG_TSMEC,       OBSREG_TSMVWC,         //  60 -  64
+  OBSREG_TSMT,        OBSREG_DST0,        OBSREG_DST1,        OBSREG_DST2,        OBSREG_DST3,           //  65 -  69
+  OBSREG_DST4,        OBSREG_DST5,        OBSREG_DST6,        OBSREG_DST7,        OBSREG_TSME25_1,       //  70 -  74
+  OBSREG_TSMEC_1,     OBSREG_TSMVWC_1,    OBSREG_TSMT_1,      OBSREG_TSME25_2,    OBSREG_TSMEC_2,        //  75 -  79
+  OBSREG_TSMVWC_2,    OBSREG_TSMT_2,      OBSREG_TSME25_3,    OBSREG_TSMEC_3,     OBSREG_TSMVWC_3,       //  80 -  84
+  OBSREG_TSMT_3,      OBSREG_TSME25_4,    OBSREG_TSMEC_4,     OBSREG_TSMVWC_4,    OBSREG_TSMT_4,         //  85 -  89
+  OBSREG_TSME25_5,    OBSREG_TSMEC_5,     OBSREG_TSMVWC_5,    OBSREG_TSMT_5,      OBSREG_TSME25_6,       //  90 -  94
+  OBSREG_TSMEC_6,     OBSREG_TSMVWC_6,    OBSREG_TSMT_6,      OBSREG_TSME25_7,    OBSREG_TSMEC_7,        //  95 -  99
+  OBSREG_TSMVWC_7,    OBSREG_TSMT_7,      OBSREG_TSME25_8,    OBSREG_TSMEC_8,     OBSREG_TSMVWC_8,       // 100 - 104
+  OBSREG_TSMT_8,      OBSREG_ST3,         OBSREG_SH3,         OBSREG_ST4,         OBSREG_SH4,            // 105 - 109
+  OBSREG_BT5,         OBSREG_BP5,         OBSREG_BT6,         OBSREG_BP6,                                // 110 - 113
+  OBSREG_COUNT
+} OBSREG_ID;
+
+typedef struct {
+  const char *tag;                    // Observation tag name as used in the JSON
+  uint8_t     type;                   // F_OBS, I_OBS or U_OBS
+  uint8_t     decimals;               // Fixed point scaling, value sent is round(value * 10^decimals)
+  uint8_t     qc;                     // OBSREG_QC_TYPE, value outside the range is replaced by the error value
+} OBSREG;
+
+typedef struct {
+  float       min;
+  float       max;
+  float       err;
+} OBSREG_QC;
+
+// Extern variables
+extern const OBSREG obs_registry[];
+
+// Function prototypes
+uint8_t obsreg_index(const char *tag);
+float obsreg_qc(uint8_t reg, float v);
@@ -8,6 +8,24 @@
 
 #define SD_ChipSelect 10    // GPIO 10 is Pin 10 on Feather and D5 on Particle Boron Board
 
+/*
+ * ======================================================================================================================
+ *  Need to Send (N2S) Queue - n2s_rate in CONFIG.TXT
+ *
+ *  Observation messages (LR, LB, LD, LM) that were not sent, or not acked when lora_ack=1, are appended
+ *  to N2S.DAT. After each observation that is delivered, up to n2s_rate of them are sent again
+ *  oldest first, with the N2S flag set in the RadioHead header. eeprom.n2sfp is the file position
+ *  of the next one to send and is saved after each one sent, so a reboot carries on from there.
+ *  SSB_N2S is set while the file has unsent messages. When all are sent the file is removed.
+ *
+ *  Record  [length u8][message type 2 chars][message, length bytes]
+ *
+ *  LF fragments and INFO are not queued. The full observation is always in the SD log.
+ * ======================================================================================================================
+ */
+#define SD_N2S_MAX_SIZE  (512UL * 1024)   // Stop adding past this, about 3000 LR messages
+#define SD_N2S_RATE_MAX  10
+
 // Extern variables
 extern File SD_fp;
 extern bool SD_exists;
@@ -16,3 +34,6 @@ extern bool SD_exists;
 void SD_initialize();
 void SD_LogObservation(char *observations);
 void SD_ClearRainTotals();
+void SD_N2S_Check();
+void SD_N2S_Append(const char *mtype, const byte *msg, int len);
+void SD_N2S_Replay();
@@ -232,6 +232,7 @@ extern bool LPS_2_exists;
  * ======================================================================================================================
  */
 #define TLW_ADDRESS     0x61
+#define TLW_READING_MS  200     // REG_READ_ST to results ready, LeafSens::newReading() waits the same
 
 extern LeafSens tlw;
 extern bool TLW_exists;
@@ -243,6 +244,7 @@ extern bool TLW_exists;
  * ======================================================================================================================
  */
 #define TSM_ADDRESS     0x63
+#define TSM_READING_MS  300     // REG_READ_START to results ready, SVCS3::newReading() waits the same
 
 extern SVCS3 tsm;
 extern bool TSM_exists;
@@ -288,4 +290,5 @@ void pm25aqi_clear();
 void pm25aqi_initialize();
 void lps_initialize();
 void tlw_initialize();
-void tsm_initialize();
\ No newline at end of file
+void tsm_initialize();
+void tinovi_start(uint8_t address, uint8_t reg);
\ No newline at end of file
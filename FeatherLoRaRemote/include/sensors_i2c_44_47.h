@@ -41,6 +41,7 @@ typedef struct {
     I2C_44_47_SENSOR_TYPE type;
     uint8_t i2c_address;
     uint8_t id;
+    uint8_t tag[2];         // obs_registry[] rows of the temperature and humidity/pressure obs
     char sn[I2C_44_77_SN_LEN];
     Adafruit_SHT31 sht3;
     Adafruit_SHT4x sht4;
@@ -9,6 +9,7 @@
 // Function prototypes
 bool I2C_Device_Exist(uint8_t address);
 void Blink(int count, int between);
+void DelaySince(unsigned long start, unsigned long ms);
 void FadeOn(unsigned int time,int increament);
 void FadeOff(unsigned int time,int decreament);
 void mysort(unsigned int a[], int n);
@@ -19,9 +19,11 @@
 #include "include/wrda.h"
 #include "include/sdcard.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/lora.h"
 #include "include/support.h"
 #include "include/time.h"
+#include "include/obs.h"
 #include "include/main.h"
 #include "include/info.h"
 
@@ -31,6 +33,7 @@
  * =======================================================================================================================
  */
 char SD_INFO_FILE[] = "INFO.TXT";       // Store INFO information in this file. Every INFO call will overwrite content
+uint32_t INFO_Fingerprint = 0;          // Fingerprint of the last full INFO delivered, 0 = none since boot
 
 /*
  * ======================================================================================================================
@@ -38,6 +41,169 @@ char SD_INFO_FILE[] = "INFO.TXT";       // Store INFO information in this file.
  * =======================================================================================================================
  */
  
+/*
+ * ======================================================================================================================
+ * INFO_FNV1a() - Continue FNV-1a 32 bit hash h over len bytes of s
+ * ======================================================================================================================
+ */
+uint32_t INFO_FNV1a(uint32_t h, const char *s, int len) {
+  while (len-- > 0) {
+    h ^= (uint8_t) *s++;
+    h *= INFO_FNV_PRIME;
+  }
+  return (h);
+}
+
+/*
+ * ======================================================================================================================
+ * INFO_PartAdd() - Add len bytes at s as the next part, return the number of parts
+ * ======================================================================================================================
+ */
+int INFO_PartAdd(INFO_PART *parts, int nparts, const char *s, int len, bool list) {
+  if ((len > 0) && (nparts < INFO_PARTS)) {
+    parts[nparts].s = s;
+    parts[nparts].len = len;
+    parts[nparts].list = list;
+    nparts++;
+  }
+  return (nparts);
+}
+
+/*
+ * ======================================================================================================================
+ * INFO_Split() - Bytes of s that fit in room, all len or up to the last boundary that fits, 0 if none does
+ *                A boundary is a comma outside a string, {} or (), before a member or between list items
+ * ======================================================================================================================
+ */
+int INFO_Split(const char *s, int len, int room, bool list) {
+  int n = 0;
+  int depth = 0;
+  bool quoted = false;
+
+  if (len <= room) {
+    return (len);
+  }
+  for (int i=1; (i<len) && (i<=room); i++) {
+    if (s[i] == '"') {
+      quoted = !quoted;
+    }
+    else if (!quoted && ((s[i] == '{') || (s[i] == '('))) {
+      depth++;
+    }
+    else if (!quoted && ((s[i] == '}') || (s[i] == ')'))) {
+      depth--;
+    }
+    else if (!quoted && !depth && (s[i] == ',') && (list || (s[i+1] == '"'))) {
+      n = i;
+    }
+  }
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * INFO_Pack() - Add the parts from part p, byte off, to the IF message in mw while they fit, then the closing }
+ *               p and off move on past what was added. Returns the number of parts too long for any message.
+ * ======================================================================================================================
+ */
+int INFO_Pack(MSGW *mw, INFO_PART *parts, int nparts, int &p, int &off) {
+  bool list = false;  // Message has a sensors list
+  int start = mw->len;
+  int skipped = 0;
+  int room;
+  int n;
+
+  while ((p < nparts) && !(list && parts[p].list)) {
+    // Room less the closing }, and for a list the key and its closing quote
+    room = LORA_MAX_MSGLEN - mw->len - 1 - ((parts[p].list) ? (int) strlen(INFO_SENSORS) + 1 : 0);
+    n = INFO_Split(parts[p].s + off, parts[p].len - off, room, parts[p].list);
+    if (!n && (mw->len > start)) {
+      break;  // Next message
+    }
+    if (!n) {
+      skipped++;
+      p++;
+      off = 0;
+      continue;
+    }
+
+    if (parts[p].list) {
+      MSGW_Str(mw, INFO_SENSORS);
+      MSGW_Mem(mw, parts[p].s + off, n);
+      MSGW_Char(mw, '"');
+      list = true;
+    }
+    else {
+      MSGW_Mem(mw, parts[p].s + off, n);
+    }
+
+    off += n;
+    if (off < parts[p].len) {
+      off += (parts[p].list) ? 1 : 0;  // Next list message starts after the comma, a member with it
+      break;
+    }
+    p++;
+    off = 0;
+  }
+  MSGW_Char(mw, '}');
+  return (skipped);
+}
+
+/*
+ * ======================================================================================================================
+ * INFO_SendParts() - Send the parts as IF messages after the header, return true if all were sent
+ *                    The IF messages go whole or not at all, they are not left in the Transmit Queue.
+ * ======================================================================================================================
+ */
+bool INFO_SendParts(const char *header, INFO_PART *parts, int nparts) {
+  MSGW mw;
+  unsigned long airtime = 0;
+  bool sent = true;
+  int msgs = 0;
+  int p = 0;
+  int off = 0;    // Bytes of parts[p] sent
+  int start;
+
+  // Dry run in msgbuf for the airtime of all the IF messages
+  while (p < nparts) {
+    MSGW_Init(&mw, msgbuf, sizeof(msgbuf));
+    MSGW_Printf(&mw, "NCSIF,%d,%d,{", cf_lora_unitid, SendMsgCount + msgs++);
+    MSGW_Str(&mw, header);
+    INFO_Pack(&mw, parts, nparts, p, off);
+    airtime += LoRaMsgAirtime(mw.len);
+  }
+  LoRaTxHeld = LoRaTxDeferAirtime(LORA_PRIO_LOW, airtime);
+  if (LoRaTxHeld) {
+    sprintf (Buffer32Bytes, "IFDO:HELD %lums", airtime);
+    Output (Buffer32Bytes);
+    return (false);
+  }
+
+  p = 0;
+  off = 0;
+  LoRaTxWhole = true;
+  while (p < nparts) {
+    // Write the IF message in place in msgbuf
+    LoRaFrameHeader(&mw, "IF");
+    MSGW_Char(&mw, '{');
+    MSGW_Str(&mw, header);
+    start = mw.len;
+    if (INFO_Pack(&mw, parts, nparts, p, off)) {
+      Output("IFDO:PART TOO LONG");
+    }
+
+    if (mw.len > (start + 1)) {
+      Output("IFDO:SENDING");
+      if (!LoRaTextSend(&mw, LORA_PRIO_LOW)) {
+        sent = false;
+        break;  // The rest would not make it whole
+      }
+    }
+  }
+  LoRaTxWhole = false;
+  return (sent);
+}
+
 /*
  * ======================================================================================================================
  * INFO_Do() - Get and Send System Information
@@ -48,325 +214,391 @@ char SD_INFO_FILE[] = "INFO.TXT";       // Store INFO information in this file.
  *   INT,   Station ID
  *   INT,   Transmit Counter
  *   JSON   Msg Battery and Status
+ *
+ * The full INFO is built once in fullmsg, the LoRa parts point into it, See info.h
+ * With info_compact=1 the full INFO is only sent when the fingerprint changes, See info.h
+ * Returns false when the INFO was held back, for an observation waiting on its slot or the duty cycle,
+ * so the caller tries again. Sent and lost is not retried, it goes with the next INFO.
  * =======================================================================================================================
  */
-void INFO_Do()
+bool INFO_Do()
 {
   char header[128];
-  char rest[128];
   char loramsg[256];
   char fullmsg[1024];   // Holds JSON observations to write to INFO.TXT
-  const char *sensorcomma = "";
+  MSGW fw;              // Writes fullmsg
+  INFO_PART parts[INFO_PARTS];  // LoRa parts of the INFO, less the header
+  int nparts = 0;
+  const char *base, *devs, *gps, *stats, *netstats, *ifps;
+  int baselen, devslen, gpslen, statslen, netstatslen, ifplen;
+  const char *sensors[INFO_SENSOR_LISTS];
+  int sensorslen[INFO_SENSOR_LISTS];
+  int nsensors = 0;
+  int start;
+  int list;
+  uint32_t ifp = INFO_FNV_INIT;
+  bool full = LoRaInfoRequest;  // Gateway asked, only once, a failed full INFO is resent when next due
+  bool request = LoRaInfoRequest;
+  const char *sensorcomma = ",\"sensors\":\"";  // Opens sensors in fullmsg, then separates the lists
   const char *comma = "";
-  int msgLength;
-  unsigned short checksum;
   float batt;
-  bool oktosend = false; 
-
-  
-  memset(header, 0, sizeof(header));
-  memset(rest, 0, sizeof(rest));
-  memset(loramsg, 0, sizeof(loramsg));
-  memset(fullmsg, 0, sizeof(fullmsg));
+  unsigned long awake = millis();      // Time awake for this send cycle
+  unsigned long idle = LoRaTxIdle;     // Of which idle waiting on the radio
 
+  LoRaInfoRequest = false;
+  LoRaTxHeld = false;
   rtc_timestamp();
   
   // BUILD HEADER ======================================================================================
 
-  sprintf (header, "\"at\":\"%s\",\"id\":%d,\"devid\":\"%s\",\"mtype\":\"IF\"",
+  snprintf (header, sizeof(header), "\"at\":\"%s\",\"id\":%d,\"devid\":\"%s\",\"mtype\":\"IF\"",
     timestamp, cf_lora_unitid, DeviceID);
 
-  sprintf (fullmsg, "{%s", header);
+  MSGW_Init(&fw, fullmsg, sizeof(fullmsg));
+  MSGW_Char(&fw, '{');
+  MSGW_Str(&fw, header);
 
 
   // BUILD BASE INFO ===================================================================================
 
+  // Fingerprint what does not change from one INFO to the next, version and configuration
+  snprintf (loramsg, sizeof(loramsg), "%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d", versioninfo, cf_obs_period, cf_elevation, 
+    cf_rtro_hour, cf_rtro_minute, cf_lora_unitid, cf_lora_txpower, cf_lora_freq, LORA_exists, cf_obs_format, cf_obs_batch);
+  ifp = INFO_FNV1a(ifp, loramsg, strlen(loramsg));
+  snprintf (loramsg, sizeof(loramsg), "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d", cf_lora_dutycycle, cf_lora_ack, cf_lora_adr, 
+    cf_lora_retries, cf_lora_lbt, cf_lora_cipher, cf_lora_crc, cf_lora_slots, cf_lora_slotwidth, cf_n2s_rate, cf_lora_relay);
+  ifp = INFO_FNV1a(ifp, loramsg, strlen(loramsg));
+  snprintf (loramsg, sizeof(loramsg), "%d,%ld,%d,%d,%d,%d", cf_lora_channels, cf_lora_chbase, cf_lora_chspace,
+    cf_lora_gwid, cf_lora_timesync, cf_obs_keyframe);
+  ifp = INFO_FNV1a(ifp, loramsg, strlen(loramsg));
+  snprintf (loramsg, sizeof(loramsg), "%d,%d,%d,%d,%d,%d,%d,%d", cf_nowind, cf_rg1_enable, cf_op1, cf_op2, cf_op3, 
+    cf_op4, cf_ds_baseline, cf_dst_resolution);
+  ifp = INFO_FNV1a(ifp, loramsg, strlen(loramsg));
+
   // Battery Voltage and System Status
   batt = vbat_get();
 
-  sprintf (rest, ",\"ver\":\"%s\",\"bv\":%.2f,\"hth\":%d,",
-    versioninfo, batt, SystemStatusBits);
+  start = fw.len;
+  MSGW_Printf(&fw, ",\"ver\":\"%s\",\"bv\":", versioninfo);
+  MSGW_Fixed(&fw, batt, 2);
+  MSGW_Printf(&fw, ",\"hth\":%d,", SystemStatusBits);
 
-  sprintf (rest+strlen(rest), "\"obsi\":\"%dm\",\"obsti\":\"%dm\",\"t2nt\":\"%ds\",",
+  MSGW_Printf(&fw, "\"obsi\":\"%dm\",\"obsti\":\"%dm\",\"t2nt\":\"%ds\",",
     cf_obs_period, cf_obs_period, seconds_to_next_obs());
 
   // Station Elevation
-  sprintf (rest+strlen(rest), "\"elev\":%d,", cf_elevation);
+  MSGW_Printf(&fw, "\"elev\":%d,", cf_elevation);
 
   // Rain total rollover offset
-  sprintf(rest+strlen(rest), "\"rtro\":\"%d:%02d\",", cf_rtro_hour, cf_rtro_minute);
+  MSGW_Printf(&fw, "\"rtro\":\"%d:%02d\",", cf_rtro_hour, cf_rtro_minute);
 
   // LoRa
   if (LORA_exists) {
-    sprintf (rest+strlen(rest), "\"lora\":\"%d,%d,%dMHz,OK\"", cf_lora_unitid, cf_lora_txpower, cf_lora_freq);  
+    MSGW_Printf(&fw, "\"lora\":\"%d,%d,%dMHz,OK\"", cf_lora_unitid, cf_lora_txpower, cf_lora_freq);  
   }
   else {
-    sprintf (rest+strlen(rest), "\"lora\":\"%d,%d,%dMHz,NF\"", cf_lora_unitid, cf_lora_txpower, cf_lora_freq);
+    MSGW_Printf(&fw, "\"lora\":\"%d,%d,%dMHz,NF\"", cf_lora_unitid, cf_lora_txpower, cf_lora_freq);
   }
+  base = fullmsg + start;
+  baselen = fw.len - start;
 
-  //================================
-  // Put the parts together and send
-  //================================
-  
-  // Grow our full message
-  sprintf (fullmsg+strlen(fullmsg), "%s", rest);
-  
-  Output("IFDO:SENDING");
-  sprintf (loramsg, "{%s%s}", header, rest);
-  SendLoRaMessage(loramsg, "IF");
-  delay(500); // Its Recommended before sending another message
-
-  // SEND DEVS ======================================================================================
+  // BUILD DEVS ======================================================================================
   
-  // Clear buffers
-  memset(loramsg, 0, sizeof(loramsg));
-  memset(rest, 0, sizeof(rest));
-
-  sprintf (rest, ",\"devs\":\"");
+  start = fw.len;
+  MSGW_Printf(&fw, ",\"devs\":\"");
 
   comma = "";
   if (eeprom_exists) {
-    sprintf (rest+strlen(rest), "%seeprom", comma);
+    MSGW_Printf(&fw, "%seeprom", comma);
     comma=",";    
   }
   if (MUX_exists) {
-    sprintf (rest+strlen(rest), "%smux", comma);
+    MSGW_Printf(&fw, "%smux", comma);
     comma=",";    
   }
   if (DSMUX_exists) {
-    sprintf (rest+strlen(rest), "%sdsmux", comma);
+    MSGW_Printf(&fw, "%sdsmux", comma);
     comma=",";    
   }
   if (SD_exists) {
-    sprintf (rest+strlen(rest), "%ssd", comma);
+    MSGW_Printf(&fw, "%ssd", comma);
     comma=",";    
   }
   if (gps_exists) {
-    sprintf (rest+strlen(rest), "%sgps", comma);
+    MSGW_Printf(&fw, "%sgps", comma);
     comma=","; 
   }
   // End of Discovered Devices List
-  sprintf (rest+strlen(rest), "\"");
+  MSGW_Printf(&fw, "\"");
+  devs = fullmsg + start;
+  devslen = fw.len - start;
+  ifp = INFO_FNV1a(ifp, devs, devslen);
 
+  start = fw.len;
   if (gps_exists) {
     // add detailed gps information
     if (gps_valid) {
-      sprintf (rest+strlen(rest), ",\"gps\":{\"lat\":%f,\"lon\":%f,\"alt\":%f,\"sat\":%d,\"hdop\":%f,\"on\":%d}",
+      MSGW_Printf(&fw, ",\"gps\":{\"lat\":%f,\"lon\":%f,\"alt\":%f,\"sat\":%d,\"hdop\":%f,\"on\":%d}",
         gps_lat, gps_lon, gps_altm, gps_sat, gps_hdop, (gps_on)?1:0);
     }
   }
+  gps = fullmsg + start;
+  gpslen = fw.len - start;
 
-  //================================
-  // Put the parts together and send
-  //================================
-  
-  // Grow our full message
-  sprintf (fullmsg+strlen(fullmsg), "%s", rest);
+  // BUILD LORA STATS ======================================================================================
+
+  start = fw.len;
+
+  // Duty cycle airtime used over the last hour, budget and drops
+  if (cf_lora_dutycycle) {
+    MSGW_Printf(&fw, ",\"ldc\":\"%lu,%lu,%u\"", 
+      LoRaDCUsed(rtc_unixtime()), LoRaDCBudget(), LoRaDCDrops);
+  }
+
+  // Spreading Factor and how the gateway last heard us
+  if (cf_lora_ack) {
+    MSGW_Printf(&fw, ",\"lack\":\"SF%d,%d,%d,%u\"", 
+      LoRaSF, LoRaAckRssi, LoRaAckSnr, LoRaAckMissed);
+  }
+
+  // Reliable mode, messages acked, retransmits and messages lost
+  if (cf_lora_retries) {
+    MSGW_Printf(&fw, ",\"lrel\":\"%u,%u,%u\"", LoRaAcked, LoRaRetries, LoRaLost);
+  }
+
+  // Listen before talk, times channel busy, ms backing off and sent while busy
+  if (cf_lora_lbt) {
+    MSGW_Printf(&fw, ",\"llbt\":\"%u,%lu,%u\"", LoRaLBTBusy, LoRaLBTWait, LoRaLBTForced);
+  }
+
+  // Time beacons, RTC steps and seconds since the last beacon
+  if (cf_lora_timesync) {
+    MSGW_Printf(&fw, ",\"ltim\":\"%d,%ld\"", LoRaTimeAdjusts, 
+      (LoRaTimeLast) ? (long) ((millis() - LoRaTimeLast) / 1000) : -1L);
+  }
+
+  // Transmit queue, messages deferred, dropped with the queue full, worst ms an observation waited to go on air
+  if (LoRaTxQDeferred || LoRaObsLatencyMax) {
+    MSGW_Printf(&fw, ",\"ltxq\":\"%u,%u,%lu\"", LoRaTxQDeferred, LoRaTxQDrops, LoRaObsLatencyMax);
+  }
+  stats = fullmsg + start;
+  statslen = fw.len - start;
+
+  // Hopping and relay in their own part, they do not fit with the above. Relay is off when hopping
+  start = fw.len;
 
-  Output("IFDO:SENDING");
-  sprintf (loramsg, "{%s%s}", header, rest);
-  SendLoRaMessage(loramsg, "IF");
-  delay(500); // Its Recommended before sending another message
+  // Frequency hopping, ms waiting for a channel to rest, messages over the dwell limit, transmits per channel
+  if (cf_lora_channels) {
+    MSGW_Printf(&fw, ",\"lhop\":\"%lu,%u", LoRaHopWait, LoRaDwellDrops);
+    for (int c=0; c<cf_lora_channels; c++) {
+      MSGW_Printf(&fw, ",%u", LoRaChTx[c]);
+    }
+    MSGW_Char(&fw, '"');
+  }
+
+  // Relay, frames queued, forwarded, duplicates, dropped, seconds listening and ms forwarding on air
+  if (cf_lora_relay) {
+    MSGW_Printf(&fw, ",\"lrly\":\"%u,%u,%u,%u,%lu,%lu\"", LoRaRelayHeard, LoRaRelayForwarded, 
+      LoRaRelayDups, LoRaRelayDrops, LoRaRelayListenTime / 1000, LoRaRelayAirtime);
+  }
+  netstats = fullmsg + start;
+  netstatslen = fw.len - start;
 
-  // SEND SENSORS PART1 ======================================================================================
+  // BUILD SENSORS PART1 ======================================================================================
   
-  // Clear buffers
-  memset(loramsg, 0, sizeof(loramsg));
-  memset(rest, 0, sizeof(rest));
+  // Opens the sensors string, or separates this list from the last, taken back if the list is empty
+  start = fw.len;
+  MSGW_Str(&fw, sensorcomma);
+  list = fw.len;
 
   // SENSORS
   comma="";
   if (BMX_1_exists) {
-    sprintf (rest+strlen(rest), "%sBMX1(%s)", comma, bmxtype[BMX_1_type]);
+    MSGW_Printf(&fw, "%sBMX1(%s)", comma, bmxtype[BMX_1_type]);
     comma=",";
   }
   if (BMX_2_exists) {
-    sprintf (rest+strlen(rest), "%sBMX2(%s)", comma, bmxtype[BMX_2_type]);
+    MSGW_Printf(&fw, "%sBMX2(%s)", comma, bmxtype[BMX_2_type]);
     comma=",";
   }
   if (MCP_1_exists) {
-    sprintf (rest+strlen(rest), "%sMCP1", comma);
+    MSGW_Printf(&fw, "%sMCP1", comma);
     comma=",";
   }
   if (MCP_2_exists) {
-    sprintf (rest+strlen(rest), "%sMCP2", comma);
+    MSGW_Printf(&fw, "%sMCP2", comma);
     comma=",";
   }
   if (MCP_3_exists) {
-    sprintf (rest+strlen(rest), "%sMCP3/gt1", comma);
+    MSGW_Printf(&fw, "%sMCP3/gt1", comma);
     comma=",";
   }
   if (MCP_4_exists) {
-    sprintf (rest+strlen(rest), "%sMCP4/gt2", comma);
+    MSGW_Printf(&fw, "%sMCP4/gt2", comma);
     comma=",";
   }
 
-  // Add 0x44-)x47 sensors to the list
-  sensor_i2c_44_47_info(rest, 128, comma);
+  // Add 0x44-0x47 sensors to the list
+  sensor_i2c_44_47_info(fullmsg + fw.len, sizeof(fullmsg) - fw.len, comma);
+  fw.len += strlen(fullmsg + fw.len);
 
   if (LPS_1_exists) {
-    sprintf (rest+strlen(rest), "%sLPS1", comma);
+    MSGW_Printf(&fw, "%sLPS1", comma);
     comma=",";
   }
   if (LPS_2_exists) {
-    sprintf (rest+strlen(rest), "%sLPS2", comma);
+    MSGW_Printf(&fw, "%sLPS2", comma);
     comma=",";
   }
   if (HIH8_exists) {
-    sprintf (rest+strlen(rest), "%sHIH8", comma);
+    MSGW_Printf(&fw, "%sHIH8", comma);
     comma=",";
   }
   if (SI1145_exists) {
-    sprintf (rest+strlen(rest), "%sSI", comma);
+    MSGW_Printf(&fw, "%sSI", comma);
     comma=",";
   }
   if (BLX_exists) {
-    sprintf (rest+strlen(rest), "%sBLX", comma);
+    MSGW_Printf(&fw, "%sBLX", comma);
     comma=",";
   }
   if (AS5600_exists) {
-    sprintf (rest+strlen(rest), "%sAS5600", comma);
+    MSGW_Printf(&fw, "%sAS5600", comma);
     comma=",";
-    sprintf (rest+strlen(rest), "%sWS(%s)", comma, pinNames[ANEMOMETER_IRQ_PIN]);
+    MSGW_Printf(&fw, "%sWS(%s)", comma, pinNames[ANEMOMETER_IRQ_PIN]);
   }
 
-  //================================
-  // Put the parts together and send
-  //================================
-  if (strlen(rest)) {
-    // Grow our full message
-    sprintf (fullmsg+strlen(fullmsg), "\"sensors\":\"%s", rest);
-    if (strlen(comma) > 0) {
-      sensorcomma=",";
-    }
-  
-    Output("IFDO:SEND SENSORS");
-    sprintf (loramsg, "{%s,\"sensors\":\"%s\"}", header, rest);
-    SendLoRaMessage(loramsg, "IF");
-    delay(500); // Its Recommended before sending another message
-
-    // Clear buffers
-    memset(loramsg, 0, sizeof(loramsg));
-    memset(rest, 0, sizeof(rest));
+  if (fw.len > list) {
+    sensors[nsensors] = fullmsg + list;
+    sensorslen[nsensors] = fw.len - list;
+    ifp = INFO_FNV1a(ifp, sensors[nsensors], sensorslen[nsensors]);
+    nsensors++;
+    sensorcomma=",";
+  }
+  else {
+    fw.len = start;
+    fullmsg[fw.len] = 0;
   }
 
-  // SEND SENSORS PART2 ======================================================================================
+  // BUILD SENSORS PART2 ======================================================================================
   
+  start = fw.len;
+  MSGW_Str(&fw, sensorcomma);
+  list = fw.len;
+
   // SENSORS  
   comma="";
   if (TLW_exists) {
-    sprintf (rest+strlen(rest), "%sTLW", comma);
+    MSGW_Printf(&fw, "%sTLW", comma);
     comma=",";
   } 
   if (TSM_exists) {
-    sprintf (rest+strlen(rest), "%sTSM", comma);
+    MSGW_Printf(&fw, "%sTSM", comma);
     comma=",";
   }
   if (HI_exists) {
-    sprintf (rest+strlen(rest), "%sHI", comma);
+    MSGW_Printf(&fw, "%sHI", comma);
     comma=",";
   }
   if (WBT_exists) {
-    sprintf (rest+strlen(rest), "%sWBT", comma);
+    MSGW_Printf(&fw, "%sWBT", comma);
     comma=",";
   }
   if (WBGT_exists) {
     if (MCP_3_exists) {
-      sprintf (rest+strlen(rest), "%sWBGT W/GLOBE", comma);
+      MSGW_Printf(&fw, "%sWBGT W/GLOBE", comma);
     }
     else {
-      sprintf (rest+strlen(rest), "%sWBGT WO/GLOBE", comma);
+      MSGW_Printf(&fw, "%sWBGT WO/GLOBE", comma);
     }
     comma=",";
   }
   if (PM25AQI_exists) {
-    sprintf (rest+strlen(rest), "%sPM25AQ(%s)", comma, pinNames[PM25AQI_PIN]);
+    MSGW_Printf(&fw, "%sPM25AQ(%s)", comma, pinNames[PM25AQI_PIN]);
     comma=",";
   }
   if (cf_rg1_enable) {
-    sprintf (rest+strlen(rest), "%sRG1(%s)", comma, pinNames[RAINGAUGE1_IRQ_PIN]); 
+    MSGW_Printf(&fw, "%sRG1(%s)", comma, pinNames[RAINGAUGE1_IRQ_PIN]); 
     comma=",";
   }
   if (cf_op1 == OP1_STATE_RAW) {
-    sprintf (rest+strlen(rest), "%sOP1R(%s)", comma, pinNames[OP1_PIN]);
+    MSGW_Printf(&fw, "%sOP1R(%s)", comma, pinNames[OP1_PIN]);
     comma=",";
   } 
   if (cf_op1 == OP1_STATE_RAIN) {
-    sprintf (rest+strlen(rest), "%sRG2(%s)", comma, pinNames[RAINGAUGE2_IRQ_PIN]);
+    MSGW_Printf(&fw, "%sRG2(%s)", comma, pinNames[RAINGAUGE2_IRQ_PIN]);
     comma=",";
   } 
   if (cf_op1 == OP1_STATE_DIST_5M) {
-    sprintf (rest+strlen(rest), "%s5MDIST(%s,%d)", 
+    MSGW_Printf(&fw, "%s5MDIST(%s,%d)", 
       comma, pinNames[DISTANCE_GAUGE_PIN], cf_ds_baseline);
     comma=",";
   } 
   if (cf_op1 == OP1_STATE_DIST_10M) {
-    sprintf (rest+strlen(rest), "%s10MDIST(%s,%d)", 
+    MSGW_Printf(&fw, "%s10MDIST(%s,%d)", 
       comma, pinNames[DISTANCE_GAUGE_PIN], cf_ds_baseline);
     comma=",";
   }
   if (cf_op2 == OP2_STATE_RAW) {
-    sprintf (rest+strlen(rest), "%sOP2R(%s)", comma, pinNames[OP2_PIN]);
+    MSGW_Printf(&fw, "%sOP2R(%s)", comma, pinNames[OP2_PIN]);
     comma=",";
   }
   if (cf_op2 == OP2_STATE_VOLTAIC) {
-    sprintf (rest+strlen(rest), "%sVBV(%s)", comma, pinNames[OP2_PIN]);
+    MSGW_Printf(&fw, "%sVBV(%s)", comma, pinNames[OP2_PIN]);
     comma=",";
   }
   if (cf_op3 == OP3_STATE_RAW) {
-    sprintf (rest+strlen(rest), "%sOP3R(%s)", comma, pinNames[OP3_PIN]);
+    MSGW_Printf(&fw, "%sOP3R(%s)", comma, pinNames[OP3_PIN]);
     comma=",";
   }
   if (cf_op4 == OP4_STATE_RAW) {
-    sprintf (rest+strlen(rest), "%sOP4R(%s)", comma, pinNames[OP4_PIN]);
+    MSGW_Printf(&fw, "%sOP4R(%s)", comma, pinNames[OP4_PIN]);
     comma=",";
   }
 
-  //================================
-  // Put the parts together and send
-  //================================
-
-  if (strlen(rest)) {
-    // Grow our full message
-    sprintf (fullmsg+strlen(fullmsg), "%s%s", sensorcomma, rest);
-    if (strlen(comma) > 0) {
-      sensorcomma=",";
-    }
-  
-    Output("IFDO:SEND SENSORS");
-    sprintf (loramsg, "{%s,\"sensors\":\"%s\"}", header, rest);
-    SendLoRaMessage(loramsg, "IF");
-    delay(500); // Its Recommended before sending another message
-
-    // Clear buffers
-    memset(loramsg, 0, sizeof(loramsg));
-    memset(rest, 0, sizeof(rest));
+  if (fw.len > list) {
+    sensors[nsensors] = fullmsg + list;
+    sensorslen[nsensors] = fw.len - list;
+    ifp = INFO_FNV1a(ifp, sensors[nsensors], sensorslen[nsensors]);
+    nsensors++;
+    sensorcomma=",";
+  }
+  else {
+    fw.len = start;
+    fullmsg[fw.len] = 0;
   }
 
-  // SEND MUX SENSORS ======================================================================================
+  // BUILD MUX SENSORS ======================================================================================
   
   // MUX SENSORS  
   comma="";
   
   if (MUX_exists) {
+    start = fw.len;
+    MSGW_Str(&fw, sensorcomma);
+    list = fw.len;
+
     for (int c=0; c<MUX_CHANNELS; c++) {
       if (mux[c].inuse) {
         for (int s = 0; s < MAX_CHANNEL_SENSORS; s++) {
           if (mux[c].sensor[s].type == m_tsm) {
-            sprintf (rest+strlen(rest), "%sTSM%d(%d.%d)", comma, mux[c].sensor[s].id, c, s);
+            MSGW_Printf(&fw, "%sTSM%d(%d.%d)", comma, mux[c].sensor[s].id, c, s);
             comma=",";
           }
         }
       }
     }
-    if (strlen(rest)) {
-      Output("IFDO:SEND MUX SENSORS");
-      // Grow our full message
-      sprintf (fullmsg+strlen(fullmsg), "%s%s\"", sensorcomma, rest);
-      Serial_writeln(fullmsg); 
-  
-      sprintf (loramsg, "{%s,\"sensors\":\"%s\"}", header, rest);
-      SendLoRaMessage(loramsg, "IF");
+
+    if (fw.len > list) {
+      sensors[nsensors] = fullmsg + list;
+      sensorslen[nsensors] = fw.len - list;
+      ifp = INFO_FNV1a(ifp, sensors[nsensors], sensorslen[nsensors]);
+      nsensors++;
+      sensorcomma=",";
+    }
+    else {
+      fw.len = start;
+      fullmsg[fw.len] = 0;
     }
   }
 
@@ -374,10 +606,63 @@ void INFO_Do()
   // Put the parts together and send
   //================================
   
-  // Adding closing }
-  sprintf (fullmsg+strlen(fullmsg), "\"}");
+  // Close the sensors string if we opened it, then the fingerprint and the closing }
+  if (strcmp(sensorcomma, ",") == 0) {
+    MSGW_Char(&fw, '"');
+  }
+  start = fw.len;
+  MSGW_Printf(&fw, ",\"ifp\":\"%08lx\"", ifp);
+  ifps = fullmsg + start;
+  ifplen = fw.len - start;
+  MSGW_Char(&fw, '}');
+  if (fw.overflow) {
+    Output("INFO TRUNC");
+  }
   Serial_writeln(fullmsg); 
 
+  // Full INFO when something changed since the last one, on boot, or when the gateway asked for it
+  full = (full || !cf_info_compact || (ifp != INFO_Fingerprint));
+  sprintf (Buffer32Bytes, "IFP:%08lx %s", ifp, (full) ? "FULL" : "COMPACT");
+  Output (Buffer32Bytes);
+
+  if (full && (cf_obs_format == OBS_FORMAT_FRAG)) {
+    // Header sent once, message split across LF messages
+    Output("IFDO:SEND FRAG");
+    full = SendLoRaFragmented(fullmsg, fw.len, LORA_PRIO_LOW);
+  }
+  else if (full) {
+    // Sensors lists as they were built, fingerprint goes with the LoRa stats
+    nparts = INFO_PartAdd(parts, nparts, base, baselen, false);
+    nparts = INFO_PartAdd(parts, nparts, devs, devslen + gpslen, false);
+    for (int i=0; i<nsensors; i++) {
+      nparts = INFO_PartAdd(parts, nparts, sensors[i], sensorslen[i], true);
+    }
+    nparts = INFO_PartAdd(parts, nparts, ifps, ifplen, false);
+    nparts = INFO_PartAdd(parts, nparts, stats, statslen, false);
+    nparts = INFO_PartAdd(parts, nparts, netstats, netstatslen, false);
+    full = INFO_SendParts(header, parts, nparts);
+  }
+  else {
+    // Fingerprint and what changes, the gateway has the rest from the last full INFO
+    char bv[MSGW_FMT_LEN];
+
+    snprintf (loramsg, sizeof(loramsg), ",\"ifp\":\"%08lx\",\"bv\":%s,\"hth\":%d,\"t2nt\":\"%ds\"", 
+      ifp, MSGW_Fmt(bv, batt, 2), SystemStatusBits, seconds_to_next_obs());
+    nparts = INFO_PartAdd(parts, nparts, loramsg, strlen(loramsg), false);
+    nparts = INFO_PartAdd(parts, nparts, gps, gpslen, false);
+    nparts = INFO_PartAdd(parts, nparts, stats, statslen, false);
+    nparts = INFO_PartAdd(parts, nparts, netstats, netstatslen, false);
+    INFO_SendParts(header, parts, nparts);
+    full = false;
+  }
+
+  if (full) {
+    INFO_Fingerprint = ifp;
+  }
+  else if (LoRaTxHeld && request) {
+    LoRaInfoRequest = true;  // Still owed to the gateway
+  }
+
   // Update INFO.TXT file
   if (SD_exists) {
     LoRaDisableSPI(); // Disable LoRA SPI0 Chip Select
@@ -395,4 +680,9 @@ void INFO_Do()
       Output ("SD:Open(Info)ERR");
     }
   }
+
+  LoRaTxWait();
+  sprintf (Buffer32Bytes, "IF AWAKE:%lums IDLE:%lums", millis() - awake, LoRaTxIdle - idle);
+  Output (Buffer32Bytes);
+  return (!LoRaTxHeld);
 }
@@ -13,11 +13,16 @@
  
 #include <RH_RF95.h>
 #include <AES.h>
+#include <ArduinoLowPower.h>
 
 #include "include/ssbits.h"
 #include "include/output.h"
 #include "include/cf.h"
+#include "include/time.h"
+#include "include/eeprom.h"
+#include "include/crc.h"
 #include "include/main.h"
+#include "include/msgw.h"
 #include "include/lora.h"
 
 /*
@@ -71,6 +76,141 @@ RH_RF95 rf95(LORA_SS, LORA_INT);
 
 bool LORA_exists = false;
 unsigned int SendMsgCount=0; // Count of Messages transmitted
+uint8_t FragMsgId=0;         // Message id of the last fragmented message
+
+/*
+ * =======================================================================================================================
+ *  Modem settings used by LoRaAirtime() - Keep in step with any rf95.set calls. These are the init() defaults
+ * =======================================================================================================================
+ */
+uint8_t  LoRaSF=7;           // Spreading Factor
+uint32_t LoRaBW=125000;      // Bandwidth Hz
+uint8_t  LoRaCR=5;           // Coding Rate denominator 4/5 to 4/8
+uint16_t LoRaPreamble=8;     // Preamble symbols
+
+/*
+ * =======================================================================================================================
+ *  Duty Cycle Budget - See lora.h
+ * =======================================================================================================================
+ */
+unsigned long LoRaDCAirtime[LORA_DC_BUCKETS]; // ms of airtime in each 5 minute bucket
+uint32_t LoRaDCSlot[LORA_DC_BUCKETS];         // 5 minute slot number the bucket holds
+unsigned int LoRaDCDrops=0;                   // Transmits dropped for the budget
+
+/*
+ * =======================================================================================================================
+ *  Gateway ACK and Adaptive Data Rate - See lora.h
+ * =======================================================================================================================
+ */
+unsigned int LoRaTxCounter=0;         // Transmit Counter of the message in msgbuf, echoed in the ACK
+uint16_t LoRaTxEpoch=0;               // CTR boot count taken with LoRaTxCounter, See lora.h Cipher
+int LoRaAckRssi=0;                    // From last ACK, how the gateway heard us
+int LoRaAckSnr=0;
+unsigned int LoRaAckMissed=0;         // ACKs not received since boot
+bool LoRaInfoRequest=false;            // Gateway asked for the full INFO in an ACK
+unsigned long LoRaTxDone=0;           // millis() when the message being acked left the radio
+
+/*
+ * =======================================================================================================================
+ *  Time Beacon - lora_timesync, See lora.h
+ * =======================================================================================================================
+ */
+long LoRaTimeOffset[LORA_TIME_SAMPLES]; // ms gateway time is ahead of the RTC
+int LoRaTimeCount=0;                  // Entries in LoRaTimeOffset
+unsigned long LoRaTimeLast=0;         // millis() of the last beacon, 0 = none
+int LoRaTimeAdjusts=0;                // Times the RTC was stepped
+unsigned long LoRaTimeReqLast=0;      // millis() of the last TQ message
+int LoRaADRMargin[LORA_ADR_HISTORY];  // Tenths of dB, most recent ACKs
+int LoRaADRCount=0;                   // Entries in LoRaADRMargin
+int LoRaADRMissRun=0;                 // ACKs missed in a row
+uint8_t LoRaSFConf=7;                 // SF before ADR, fallen back to when the top SF hears nothing
+const int LoRaSNRFloor[] = { -75, -100, -125, -150, -175, -200 };  // Tenths of dB, SF7 to SF12
+
+/*
+ * =======================================================================================================================
+ *  Reliable Mode Statistics - lora_retries
+ * =======================================================================================================================
+ */
+unsigned int LoRaAcked=0;             // Messages acked, first try or after retries
+unsigned int LoRaRetries=0;           // Retransmits
+unsigned int LoRaLost=0;              // Messages not acked after all retries
+
+/*
+ * =======================================================================================================================
+ *  Listen Before Talk Statistics - lora_lbt
+ * =======================================================================================================================
+ */
+unsigned int LoRaLBTBusy=0;           // CAD found the channel busy
+unsigned long LoRaLBTWait=0;          // ms spent backing off
+unsigned int LoRaLBTForced=0;         // Sent with channel still busy after LORA_LBT_TRIES
+
+/*
+ * =======================================================================================================================
+ *  Transmit Pipeline - send() returns while the message is on air, See lora.h
+ * =======================================================================================================================
+ */
+unsigned long LoRaNextTx=0;           // millis() when the next transmit may start
+unsigned long LoRaTxIdle=0;           // ms idled waiting on TxDone, message spacing and backoffs
+
+/*
+ * =======================================================================================================================
+ *  Relay - lora_relay, See lora.h
+ * =======================================================================================================================
+ */
+typedef struct {
+  uint8_t from;                       // RadioHead header of the neighbor's frame
+  uint8_t id;
+  uint8_t flags;
+  uint8_t len;
+  byte    buf[RH_RF95_MAX_MESSAGE_LEN];  // As received, still encrypted
+} LORA_RELAY_FRAME;
+
+LORA_RELAY_FRAME LoRaRelayQueue[LORA_RELAY_QUEUE];
+int LoRaRelayCount=0;                 // Frames in LoRaRelayQueue
+uint16_t LoRaRelaySeen[LORA_RELAY_SEEN]; // from << 8 | id of frames heard
+int LoRaRelaySeenCount=0;
+int LoRaRelaySeenNext=0;
+unsigned int LoRaRelayHeard=0;        // Frames queued to forward
+unsigned int LoRaRelayForwarded=0;
+unsigned int LoRaRelayDups=0;         // Frames already heard
+unsigned int LoRaRelayDrops=0;        // Hop limit, queue full or duty cycle
+unsigned long LoRaRelayListenTime=0;  // ms in receive listening for neighbors
+unsigned long LoRaRelayAirtime=0;     // ms on air forwarding
+
+/*
+ * =======================================================================================================================
+ *  Frequency Hopping - lora_channels, See lora.h
+ * =======================================================================================================================
+ */
+int LoRaCh=0;                         // Channel of the message being sent
+unsigned long LoRaChLast[LORA_CH_MAX];  // millis() of the last transmit on the channel
+unsigned long LoRaChRest[LORA_CH_MAX];  // ms the channel rests after it
+unsigned int LoRaChTx[LORA_CH_MAX];   // Transmits on each channel
+unsigned long LoRaHopWait=0;          // ms waiting for a resting channel
+unsigned int LoRaDwellDrops=0;        // Messages over LORA_DWELL_MAX
+uint8_t LoRaSFMax=LORA_SF_MAX;        // Highest SF ADR may pick, a full frame fits LORA_DWELL_MAX
+
+/*
+ * =======================================================================================================================
+ *  Transmit Queue - See lora.h
+ * =======================================================================================================================
+ */
+typedef struct {
+  int prio;
+  unsigned int counter;               // Transmit Counter in the message, for the ACK, header id and CTR nonce
+  uint16_t epoch;                     // CTR boot count taken with the counter
+  int len;
+  char msg[LORA_MAX_MSGLEN];          // Length and checksum filled in, not encrypted
+} LORA_TXQ;
+
+LORA_TXQ LoRaTxQ[LORA_TXQ_LEN];
+int LoRaTxQCount=0;                   // Entries in LoRaTxQ, oldest first
+bool LoRaObsWaiting=false;            // Observation taken, waiting for its slot
+unsigned int LoRaTxQDeferred=0;       // Messages deferred
+unsigned int LoRaTxQDrops=0;          // Messages dropped with the queue full
+bool LoRaTxWhole=false;               // Sending a message of several frames, a deferred frame is not queued
+bool LoRaTxHeld=false;                // Last message of several frames was held back whole, try it again later
+unsigned long LoRaObsLatencyMax=0;    // ms, worst observation handoff to on air
 
 /*
  * ======================================================================================================================
@@ -78,12 +218,60 @@ unsigned int SendMsgCount=0; // Count of Messages transmitted
  * =======================================================================================================================
  */
 
+/*
+ * =======================================================================================================================
+ * LoRaTxWait() - Idle in low power until the message on air is sent
+ * =======================================================================================================================
+ */
+void LoRaTxWait() {
+  if (LORA_exists && (rf95.mode() == RHGenericDriver::RHModeTx)) {
+    unsigned long start = millis();
+    while (rf95.mode() == RHGenericDriver::RHModeTx) {
+      LowPower.idle();  // TxDone interrupt or the next 1ms tick wakes us
+    }
+    LoRaTxIdle += millis() - start;
+  }
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTxSpacing() - Idle in low power until the previous message is sent and the spacing after it is over
+ * =======================================================================================================================
+ */
+void LoRaTxSpacing() {
+  unsigned long start;
+
+  LoRaTxWait();
+  start = millis();
+  while ((long)(millis() - LoRaNextTx) < 0) {
+    LowPower.idle();
+  }
+  LoRaTxIdle += millis() - start;
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaIdleWait() - Idle in low power for ms, used for retry and LBT backoffs
+ * =======================================================================================================================
+ */
+void LoRaIdleWait(unsigned long ms) {
+  unsigned long start = millis();
+
+  while ((millis() - start) < ms) {
+    LowPower.idle();  // Next 1ms tick wakes us
+  }
+  LoRaTxIdle += millis() - start;
+}
+
 /*
  * =======================================================================================================================
  * LoRaDisableSPI() 
  * =======================================================================================================================
  */
 void LoRaDisableSPI() {
+  // Radio interrupt on TxDone uses SPI, let it finish before the SPI bus is used for other things
+  LoRaTxWait();
+
   // Disable LoRA SPI0 Chip Select
   pinMode(LORA_SS, OUTPUT);
   digitalWrite(LORA_SS, HIGH);
@@ -96,6 +284,7 @@ void LoRaDisableSPI() {
  */
 void LoRaSleep() {
   if (LORA_exists) {
+    LoRaTxWait();
     rf95.sleep(); // LoRa will stay in sleep mode until woken by changing mode to idle, transmit or receive.
                   // (eg by calling send(), recv(), available() etc
   }
@@ -103,37 +292,776 @@ void LoRaSleep() {
 
 /*
  * =======================================================================================================================
- * SendLoraAESMsg() 
+ * LoRaAirtimeSF() - Time on air in ms for a payload of len bytes at spreading factor sf
+ * 
+ *   Semtech SX1276 datasheet / AN1200.13. Explicit header and CRC on, as RH_RF95 sends.
+ *   Low data rate optimize is on when a symbol is over 16ms, as RH_RF95::setLowDatarate() does.
+ * =======================================================================================================================
+ */
+unsigned long LoRaAirtimeSF(int len, uint8_t sf) {
+  double tsym = (double)(1UL << sf) * 1000.0 / LoRaBW;       // ms per symbol
+  int de = (tsym > 16.0) ? 1 : 0;
+  long num = (8L * len) - (4L * sf) + 28 + 16;               // 16 = CRC, explicit header adds 0
+  long den = 4L * (sf - (2 * de));
+  long nsym = 8;
+
+  if (num > 0) {
+    nsym += ((num + den - 1) / den) * LoRaCR;               // ceil() * (CR + 4)
+  }
+  return ((unsigned long) (((LoRaPreamble + 4.25) * tsym) + (nsym * tsym) + 0.5));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaAirtime() - Time on air in ms for a payload of len bytes at the current modem settings
+ * =======================================================================================================================
+ */
+unsigned long LoRaAirtime(int len) {
+  return (LoRaAirtimeSF(len, LoRaSF));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaCipherLen() - Bytes on air, less the RadioHead header, for a message of len bytes
+ * =======================================================================================================================
+ */
+int LoRaCipherLen(int len) {
+  return ((cf_lora_cipher == LORA_CIPHER_CTR) ? (LORA_CTR_NONCE + len) : (((len / N_BLOCK) + 1) * N_BLOCK));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaMsgAirtime() - Time on air in ms for a message of len bytes, as encrypted and with the RadioHead header
+ * =======================================================================================================================
+ */
+unsigned long LoRaMsgAirtime(int len) {
+  return (LoRaAirtime(LoRaCipherLen(len) + RH_RF95_HEADER_LEN));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaFrameFits() - Return false if a message of len bytes can never be sent, too large or, hopping, over
+ *                   LORA_DWELL_MAX at the lowest SF
+ * =======================================================================================================================
+ */
+bool LoRaFrameFits(int len) {
+  if (len > LORA_MAX_MSGLEN) {
+    return (false);
+  }
+  if (cf_lora_channels && (LoRaAirtimeSF(LoRaCipherLen(len) + RH_RF95_HEADER_LEN, LORA_SF_MIN) > LORA_DWELL_MAX)) {
+    return (false);
+  }
+  return (true);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaDCBudget() - Airtime ms allowed per rolling hour, 0 = no limit
+ * =======================================================================================================================
+ */
+unsigned long LoRaDCBudget() {
+  return (3600UL * cf_lora_dutycycle);   // 3600000ms * (dutycycle / 1000)
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaDCUsed() - Airtime ms used over the hour up to unix time t
+ * =======================================================================================================================
+ */
+unsigned long LoRaDCUsed(uint32_t t) {
+  uint32_t slot = t / LORA_DC_BUCKET_SECS;
+  unsigned long used = 0;
+
+  for (int b=0; b<LORA_DC_BUCKETS; b++) {
+    if ((slot - LoRaDCSlot[b]) < LORA_DC_BUCKETS) {  // Bucket is within the last hour
+      used += LoRaDCAirtime[b];
+    }
+  }
+  return (used);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaDCCheck() - Return true if airtime ms can be sent at unix time t without going over budget
+ * =======================================================================================================================
+ */
+bool LoRaDCCheck(uint32_t t, unsigned long airtime, int prio) {
+  unsigned long budget = LoRaDCBudget();
+
+  if (budget == 0) {
+    return (true);
+  }
+  budget -= (budget / 8) * prio;  // Each class keeps some for the classes above it
+  return ((LoRaDCUsed(t) + airtime) <= budget);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaDCAdd() - Add airtime ms sent at unix time t to its bucket
+ * =======================================================================================================================
+ */
+void LoRaDCAdd(uint32_t t, unsigned long airtime) {
+  uint32_t slot = t / LORA_DC_BUCKET_SECS;
+  int b = slot % LORA_DC_BUCKETS;
+
+  if (LoRaDCSlot[b] != slot) {  // Bucket is from a previous hour, reuse it
+    LoRaDCSlot[b] = slot;
+    LoRaDCAirtime[b] = 0;
+  }
+  LoRaDCAirtime[b] += airtime;
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaDCTime() - Unix time for the duty cycle buckets. Do not use rtc_unixtime(), it changes now
+ * =======================================================================================================================
+ */
+uint32_t LoRaDCTime() {
+  if (RTC_valid) {
+    return (rtc.now().unixtime());
+  }
+  return (millis() / 1000);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaIV() - Initialization Vector is AES_MYIV repeated twice
+ * =======================================================================================================================
+ */
+void LoRaIV(byte *iv) {
+  memcpy(iv, &AES_MYIV, 8);
+  memcpy(iv+8, &AES_MYIV, 8);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaCBCEncrypt() - AES-128-CBC with PKCS#7 padding, return cipher length. Key schedule set in lora_cf_validate()
+ * =======================================================================================================================
+ */
+int LoRaCBCEncrypt(const byte *plain, int len, byte *cipher) {
+  int pad = N_BLOCK - (len % N_BLOCK);
+  byte padded[len + pad];
+  byte iv[N_BLOCK];
+
+  memcpy(padded, plain, len);
+  memset(padded+len, pad, pad);
+  LoRaIV(iv);
+  aes.cbc_encrypt(padded, cipher, (len + pad) / N_BLOCK, iv);
+  return (len + pad);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaCTREncrypt() - AES-128-CTR, See lora.h. Return nonce plus cipher length, cipher is the same length as plain
+ * =======================================================================================================================
+ */
+int LoRaCTREncrypt(const byte *plain, int len, byte *out) {
+  uint16_t seq = LoRaTxCounter & 0xFFFF;
+  byte ctr[N_BLOCK];
+  byte ks[N_BLOCK];
+
+  // Nonce sent in the clear, epoch was fixed when the header took the counter
+  out[0] = LoRaTxEpoch & 0xFF;
+  out[1] = LoRaTxEpoch >> 8;
+  out[2] = seq & 0xFF;
+  out[3] = seq >> 8;
+
+  memcpy(ctr, &AES_MYIV, 8);
+  memcpy(ctr+8, out, LORA_CTR_NONCE);
+  for (int i=0; i<len; i++) {
+    if ((i % N_BLOCK) == 0) {
+      uint32_t blk = i / N_BLOCK;
+      ctr[12] = blk >> 24;
+      ctr[13] = blk >> 16;
+      ctr[14] = blk >> 8;
+      ctr[15] = blk;
+      aes.encrypt(ctr, ks);
+    }
+    out[LORA_CTR_NONCE + i] = plain[i] ^ ks[i % N_BLOCK];
+  }
+  return (LORA_CTR_NONCE + len);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaSetSF() - Change Spreading Factor, RH_RF95 sets low data rate optimize for us
+ * =======================================================================================================================
+ */
+void LoRaSetSF(uint8_t sf) {
+  rf95.setSpreadingFactor(sf);
+  LoRaSF = sf;
+  sprintf (Buffer32Bytes, "LoRa SF%d", sf);
+  Output (Buffer32Bytes);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaAckWait() - Listen for the gateway ACK of LoRaTxCounter, return true if received
+ * =======================================================================================================================
+ */
+bool LoRaAckWait() {
+  byte cipher[RH_RF95_MAX_MESSAGE_LEN];
+  byte plain[LORA_ACK_LEN];
+  byte iv[N_BLOCK];
+  uint8_t len;
+  unsigned long window = LORA_ACK_TURNAROUND + LoRaAirtime(LORA_ACK_LEN + RH_RF95_HEADER_LEN);
+  unsigned long start = millis();
+  unsigned long elapsed;
+
+  while ((elapsed = millis() - start) < window) {
+    if (!rf95.waitAvailableTimeout(window - elapsed)) {
+      break;
+    }
+    len = sizeof(cipher);
+    if (!rf95.recv(cipher, &len) || (len != LORA_ACK_LEN) || (rf95.headerFrom() != cf_lora_gwid)) {
+      continue;  // Not for us, keep listening
+    }
+
+    LoRaIV(iv);
+    aes.cbc_decrypt(cipher, plain, 1, iv);
+
+    if ((plain[0] == 'A') && (plain[1] == 'K') && (plain[2] == cf_lora_unitid) &&
+        ((plain[3] | (plain[4] << 8)) == (LoRaTxCounter & 0xFFFF))) {
+      LoRaAckRssi = (int16_t) (plain[5] | (plain[6] << 8));
+      LoRaAckSnr  = (int8_t) plain[7];
+      if (plain[8] & LORA_ACK_INFO) {
+        LoRaInfoRequest = true;
+      }
+      if (plain[8] & LORA_ACK_TIME) {
+        LoRaTimeBeacon((uint32_t) plain[9] | ((uint32_t) plain[10] << 8) | 
+          ((uint32_t) plain[11] << 16) | ((uint32_t) plain[12] << 24), plain[13] | (plain[14] << 8));
+      }
+      sprintf (Buffer32Bytes, "LoRa ACK %d,%d", LoRaAckRssi, LoRaAckSnr);
+      Output (Buffer32Bytes);
+      return (true);
+    }
+  }
+  LoRaAckMissed++;
+  Output ("LoRa ACK Missed");
+  return (false);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTimeBeacon() - Gateway time from an ACK, discipline the RTC with it. See lora.h
+ * =======================================================================================================================
+ */
+void LoRaTimeBeacon(uint32_t gwsec, uint16_t gwms) {
+  unsigned long elapsed = millis() - LoRaTxDone;   // Since the gateway received our message
+  uint32_t local = rtc.now().unixtime();           // Not rtc_unixtime(), leave "now" alone
+  long offset;
+  long sorted[LORA_TIME_SAMPLES];
+
+  if (!cf_lora_timesync || (gwms > 999)) {
+    return;
+  }
+  LoRaTimeLast = millis();
+
+  if (!RTC_valid || (labs((long) (gwsec - local)) > LORA_TIME_FAR)) {
+    // Nothing better to go on, or so far off the median is not needed, set the clock
+    rtc.adjust(DateTime(gwsec + ((gwms + elapsed) / 1000)));
+    RTC_valid = true;
+    LoRaTimeAdjusts++;
+    LoRaTimeCount = 0;
+    Output ("RTC Set by Beacon");
+    return;
+  }
+
+  // Gateway time now less RTC time now, in ms
+  offset = ((long) (gwsec - local) * 1000) + gwms + (long) elapsed - 500;
+
+  LoRaTimeOffset[LoRaTimeCount++] = offset;
+  if (LoRaTimeCount < LORA_TIME_SAMPLES) {
+    return;
+  }
+  LoRaTimeCount = 0;
+
+  // Median, insertion sort of a few samples
+  for (int i=0; i<LORA_TIME_SAMPLES; i++) {
+    int j = i;
+    while ((j > 0) && (sorted[j-1] > LoRaTimeOffset[i])) {
+      sorted[j] = sorted[j-1];
+      j--;
+    }
+    sorted[j] = LoRaTimeOffset[i];
+  }
+  offset = sorted[LORA_TIME_SAMPLES / 2];
+
+  sprintf (Buffer32Bytes, "RTC Beacon %ldms", offset);
+  Output (Buffer32Bytes);
+
+  if (labs(offset) >= (cf_lora_timesync * 1000L)) {
+    // Round to whole seconds and step the RTC
+    offset = (offset + ((offset < 0) ? -500 : 500)) / 1000;
+    rtc.adjust(DateTime(rtc.now().unixtime() + offset));
+    LoRaTimeAdjusts++;
+    sprintf (Buffer32Bytes, "RTC Stepped %lds", offset);
+    Output (Buffer32Bytes);
+  }
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTimeSynced() - Return true if gateway beacons are keeping the RTC
+ * =======================================================================================================================
+ */
+bool LoRaTimeSynced() {
+  return (cf_lora_timesync && cf_lora_ack && LoRaTimeLast &&
+          ((millis() - LoRaTimeLast) < (3600UL * RTC_UPDATE_INTERVAL * 1000)));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTimeRequest() - RTC not valid, ask the gateway for the time. Return true if the RTC was set
+ * =======================================================================================================================
+ */
+bool LoRaTimeRequest() {
+  if (!cf_lora_timesync || !cf_lora_ack || !LORA_exists) {
+    return (false);
+  }
+  if (LoRaTimeReqLast && ((millis() - LoRaTimeReqLast) < LORA_TIME_REQUEST)) {
+    return (false);
+  }
+  LoRaTimeReqLast = millis();
+
+  Output ("LoRa TQ");
+  SendLoRaMessage("", "TQ");
+  return (RTC_valid);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaADR() - Step Spreading Factor from ACK result, See lora.h
+ * =======================================================================================================================
+ */
+void LoRaADR(bool acked) {
+  int sf = LoRaSF;
+
+  if (acked) {
+    int margin = (LoRaAckSnr * 10) - LoRaSNRFloor[LoRaSF - LORA_SF_MIN] - LORA_ADR_INSTALL;
+
+    LoRaADRMissRun = 0;
+    if (margin < 0) {
+      sf++;
+    }
+    else {
+      // Keep the most recent margins
+      if (LoRaADRCount == LORA_ADR_HISTORY) {
+        memmove (LoRaADRMargin, LoRaADRMargin+1, sizeof(int) * (LORA_ADR_HISTORY-1));
+        LoRaADRCount--;
+      }
+      LoRaADRMargin[LoRaADRCount++] = margin;
+
+      if (LoRaADRCount == LORA_ADR_HISTORY) {
+        sf--;
+        for (int i=0; i<LoRaADRCount; i++) {
+          if (LoRaADRMargin[i] < LORA_ADR_DOWN) {
+            sf++;  // Not enough margin every time, stay
+            break;
+          }
+        }
+      }
+    }
+  }
+  else {
+    LoRaADRMissRun++;
+    if ((LoRaSF < LoRaSFMax) && (LoRaADRMissRun >= LORA_ADR_MISSES)) {
+      sf++;
+    }
+    else if (LoRaADRMissRun >= LORA_ADR_FALLBACK) {
+      // Nothing heard at the top SF either, more likely the gateway is down than out of reach
+      sf = LoRaSFConf;
+      LoRaADRMissRun = 0;
+      Output ("LoRa ADR Fallback");
+    }
+  }
+
+  sf = (sf < LORA_SF_MIN) ? LORA_SF_MIN : (sf > LoRaSFMax) ? LoRaSFMax : sf;
+  if (sf != LoRaSF) {
+    LoRaSetSF(sf);
+    LoRaADRCount = 0;
+    LoRaADRMissRun = 0;
+  }
+
+  // Only an SF picked from an ACK is kept, misses alone could be a gateway outage
+  if (acked && (eeprom_lora.sf != LoRaSF)) {
+    eeprom_lora.sf = LoRaSF;
+    EEPROM_LoRaUpdate();
+  }
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaHopChannel() - Channel for a message from unitid with header id (Transmit Counter low 8 bits). See lora.h
+ * =======================================================================================================================
+ */
+int LoRaHopChannel(uint8_t unitid, uint8_t id) {
+  uint32_t x = ((uint32_t) unitid << 8) | id;
+
+  x ^= x >> 16;
+  x *= 0x7FEB352DUL;
+  x ^= x >> 15;
+  x *= 0x846CA68BUL;
+  x ^= x >> 16;
+  return (x % cf_lora_channels);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaHop() - Tune to the attempt's channel once it has rested, return false if airtime is over the dwell limit
+ * =======================================================================================================================
+ */
+bool LoRaHop(unsigned long airtime, int attempt) {
+  unsigned long start;
+
+  if (!cf_lora_channels) {
+    return (true);
+  }
+  if (airtime > LORA_DWELL_MAX) {
+    LoRaDwellDrops++;
+    sprintf (Buffer32Bytes, "LoRa Dwell Drop %lums", airtime);
+    Output (Buffer32Bytes);
+    return (false);
+  }
+
+  // Retry r moves up r channels, the channel just used rests for 50x its airtime
+  LoRaCh = (LoRaHopChannel(cf_lora_unitid, LoRaTxCounter & 0xFF) + attempt) % cf_lora_channels;
+  start = millis();
+  while ((millis() - LoRaChLast[LoRaCh]) < LoRaChRest[LoRaCh]) {
+    LowPower.idle();
+  }
+  LoRaHopWait += millis() - start;
+
+  rf95.setFrequency((cf_lora_chbase + ((long) LoRaCh * cf_lora_chspace)) / 1000.0);
+  return (true);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaHopSent() - Charge the airtime just sent to its channel
+ * =======================================================================================================================
+ */
+void LoRaHopSent(unsigned long airtime) {
+  if (cf_lora_channels) {
+    LoRaChLast[LoRaCh] = millis();
+    LoRaChRest[LoRaCh] = airtime * (LORA_DWELL_WINDOW / LORA_DWELL_MAX);
+    LoRaChTx[LoRaCh]++;
+  }
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaChannelClear() - Channel Activity Detection with random backoff, return false if still busy
+ * =======================================================================================================================
+ */
+bool LoRaChannelClear() {
+  unsigned long backoff;
+
+  for (int i=0; i<LORA_LBT_TRIES; i++) {
+    if (!rf95.isChannelActive()) {
+      return (true);
+    }
+    // Window doubles each time the channel is found busy
+    LoRaLBTBusy++;
+    backoff = random(LORA_LBT_MIN, LORA_LBT_MAX << i);
+    LoRaLBTWait += backoff;
+    sprintf (Buffer32Bytes, "LoRa Busy, wait %lums", backoff);
+    Output (Buffer32Bytes);
+    LoRaIdleWait(backoff);
+  }
+  LoRaLBTForced++;
+  return (false);
+}
+
+/*
+ * =======================================================================================================================
+ * SendLoraAESMsg() - Encrypt and transmit, return false if not sent
  * =======================================================================================================================
  */
-void SendLoraAESMsg (int bits, char *msg, int msgLength)
+bool SendLoraAESMsg (char *msg, int msgLength, int prio)
 {
   if (LORA_exists) {
 
-    if (msgLength > 239) { // leave padding headroom. // Max length of message is 255
+    if (msgLength > LORA_MAX_MSGLEN) { // leave padding headroom. // Max length of message is 255
       Output("LoRa Payload too large");
-      return;
+      return (false);
     }
 
-    int paddedLength = msgLength + N_BLOCK - msgLength % N_BLOCK;
-    byte cipher [paddedLength] ;
-    byte iv [N_BLOCK] ;
-    byte *b;
+    byte cipher [LORA_MAX_MSGLEN + N_BLOCK] ;
+    unsigned long handoff = millis();
+    int paddedLength;
+    unsigned long airtime;
+    unsigned long backoff;
+    uint32_t t;
+    bool sent = false;
+    bool acked = false;
   
-    aes.iv_inc();
-    aes.set_IV(AES_MYIV);
-    aes.get_IV(iv);
-    aes.do_aes_encrypt((byte *)msg, msgLength, cipher, AES_KEY, bits, iv); // Results are placed in cypher variable
-    rf95.send(cipher, paddedLength);
-    rf95.waitPacketSent();
-
-    LoRaDisableSPI(); // Disable LoRA SPI0 Chip Select
-  
-    Output("LoRa Transmitted");
+    if (cf_lora_cipher == LORA_CIPHER_CTR) {
+      paddedLength = LoRaCTREncrypt((byte *)msg, msgLength, cipher);
+    }
+    else {
+      paddedLength = LoRaCBCEncrypt((byte *)msg, msgLength, cipher);
+    }
+
+    // Retries resend the same cipher, the gateway drops duplicates by Transmit Counter
+    for (int attempt=0; attempt<=cf_lora_retries; attempt++) {
+      if (attempt) {
+        // Exponential backoff with jitter so units that collided do not collide again
+        backoff = LORA_RETRY_BASE << (attempt-1);
+        backoff = (backoff > LORA_RETRY_CAP) ? LORA_RETRY_CAP : backoff;
+        backoff = (backoff / 2) + random(backoff / 2 + 1);
+        sprintf (Buffer32Bytes, "LoRa Retry %d in %lums", attempt, backoff);
+        Output (Buffer32Bytes);
+        LoRaIdleWait(backoff);
+        LoRaRetries++;
+      }
+
+      // Airtime can change between attempts when ADR steps SF
+      airtime = LoRaAirtime(paddedLength + RH_RF95_HEADER_LEN);
+      t = LoRaDCTime();
+      if (!LoRaDCCheck(t, airtime, prio)) {
+        LoRaDCDrops++;
+        sprintf (Buffer32Bytes, "LoRa DC Drop %lums", airtime);
+        Output (Buffer32Bytes);
+        break;
+      }
+
+      // Message was encrypted while the last one was on air, now wait for it and the spacing after it
+      LoRaTxSpacing();
+
+      // Radio is idle, safe to retune
+      if (!LoRaHop(airtime, attempt)) {
+        break;
+      }
+
+      if (cf_lora_lbt && !LoRaChannelClear()) {
+        Output ("LoRa LBT Busy, Sending");
+      }
+
+      rf95.send(cipher, paddedLength);  // Returns while on air
+      LoRaNextTx = millis() + airtime + constrain(airtime, LORA_IFS_MIN, LORA_IFS_MAX);
+      LoRaDCAdd(t, airtime);
+      LoRaHopSent(airtime);
+      if ((prio == LORA_PRIO_HIGH) && !sent && ((millis() - handoff) > LoRaObsLatencyMax)) {
+        LoRaObsLatencyMax = millis() - handoff;
+      }
+      sent = true;
+
+      sprintf (Buffer32Bytes, "LoRa Transmitted %lums", airtime);
+      Output (Buffer32Bytes);
+
+      if (!cf_lora_ack) {
+        break;
+      }
+      LoRaTxWait();
+      LoRaTxDone = millis();
+      acked = LoRaAckWait();
+      rf95.setModeIdle();  // Leave receive
+      if (cf_lora_adr) {
+        LoRaADR(acked);
+      }
+      if (acked) {
+        break;
+      }
+    }
+
+    if (sent && cf_lora_retries) {
+      if (acked) {
+        LoRaAcked++;
+      }
+      else {
+        LoRaLost++;
+        Output ("LoRa Lost");
+      }
+    }
+
+    return ((cf_lora_ack) ? acked : sent);
   }
   else {
     Output("LoRa TX Failed");
+    return (false);
+  }
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTxDefer() - Return true if a message of class prio and len bytes should wait. See lora.h
+ * =======================================================================================================================
+ */
+bool LoRaTxDefer(int prio, int len) {
+  return (LoRaTxDeferAirtime(prio, LoRaMsgAirtime(len)));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTxDeferAirtime() - Return true if messages of class prio, airtime ms in all, should wait. See lora.h
+ * =======================================================================================================================
+ */
+bool LoRaTxDeferAirtime(int prio, unsigned long airtime) {
+  if (prio == LORA_PRIO_HIGH) {
+    return (false);
+  }
+  if (LoRaObsWaiting) {
+    return (true);
+  }
+  return (!LoRaDCCheck(LoRaDCTime(), airtime, prio));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTxQueueAdd() - Hold a message to send after the next observation, return false if dropped
+ * =======================================================================================================================
+ */
+bool LoRaTxQueueAdd(int prio, const char *msg, int len) {
+  LORA_TXQ *q;
+  int victim = -1;
+
+  if (LoRaTxQCount >= LORA_TXQ_LEN) {
+    // Full, displace the newest of the lowest class below ours
+    for (int i=0; i<LoRaTxQCount; i++) {
+      if ((LoRaTxQ[i].prio > prio) && ((victim < 0) || (LoRaTxQ[i].prio >= LoRaTxQ[victim].prio))) {
+        victim = i;
+      }
+    }
+    LoRaTxQDrops++;
+    if (victim < 0) {
+      Output ("LoRa TXQ Full, Drop");
+      return (false);
+    }
+    Output ("LoRa TXQ Full, Displace");
+    memmove (&LoRaTxQ[victim], &LoRaTxQ[victim+1], (LoRaTxQCount - victim - 1) * sizeof(LORA_TXQ));
+    LoRaTxQCount--;
+  }
+
+  q = &LoRaTxQ[LoRaTxQCount++];
+  q->prio = prio;
+  q->counter = LoRaTxCounter;
+  q->epoch = LoRaTxEpoch;
+  q->len = len;
+  memcpy (q->msg, msg, len);
+  LoRaTxQDeferred++;
+
+  sprintf (Buffer32Bytes, "LoRa TXQ Defer %d,%d", prio, LoRaTxQCount);
+  Output (Buffer32Bytes);
+  return (true);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTxQueueFlush() - Send deferred messages highest class first, those still short of budget stay queued
+ * =======================================================================================================================
+ */
+void LoRaTxQueueFlush() {
+  LORA_TXQ *q;
+  int kept;
+
+  for (int prio=LORA_PRIO_EVENT; prio<=LORA_PRIO_N2S; prio++) {
+    for (int i=0; i<LoRaTxQCount; i++) {
+      q = &LoRaTxQ[i];
+      if ((q->prio != prio) || !q->len || LoRaTxDefer(prio, q->len)) {
+        continue;
+      }
+      LoRaTxCounter = q->counter;
+      LoRaTxEpoch = q->epoch;
+      rf95.setHeaderId(q->counter & 0xFF);
+      SendLoraAESMsg (q->msg, q->len, prio);
+      q->len = 0;  // Sent or not, it had its turn
+    }
+  }
+
+  // Close up the gaps, keeps the oldest first
+  kept = 0;
+  for (int i=0; i<LoRaTxQCount; i++) {
+    if (LoRaTxQ[i].len) {
+      if (kept != i) {
+        LoRaTxQ[kept] = LoRaTxQ[i];
+      }
+      kept++;
+    }
+  }
+  LoRaTxQCount = kept;
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaFrameHeader() - Start a LoRa message in msgbuf with writer w, returns the header length
+ * 
+ *   NCS    Length (N) and Checksum (CS)
+ *   MT,    Message Type, LR, LB or IF
+ *   INT,   Station ID
+ *   INT,   Transmit Counter
+ * =======================================================================================================================
+ */
+int LoRaFrameHeader(MSGW *w, const char *mtype) {
+  // N will be replaced with binary value (byte) representing (string length - 1)
+  //    This is how we can send variable length AES encrypted strings
+  //    The receiving side need to know characters folling this first byte
+  // CS is the place holder for the Checksum
+  // First counter of a new 65536 block gets a new CTR epoch now, not when it is encrypted, a frame
+  // can be dropped or queued in between
+  if ((cf_lora_cipher == LORA_CIPHER_CTR) && ((SendMsgCount & 0xFFFF) == 0) && (SendMsgCount != 0)) {
+    if (eeprom_lora.bootcnt == 0xFFFF) {
+      eeprom_lora.noctr = 1;
+      cf_lora_cipher = LORA_CIPHER_CBC;
+      Output ("LoRa CTR Epochs Used, CBC");
+    }
+    else {
+      eeprom_lora.bootcnt++;
+    }
+    EEPROM_LoRaUpdate();
+  }
+  LoRaTxEpoch = eeprom_lora.bootcnt;
+  LoRaTxCounter = SendMsgCount;
+  rf95.setHeaderId(SendMsgCount & 0xFF);  // Relays drop duplicates by from and id
+  MSGW_Init(w, msgbuf, sizeof(msgbuf));
+  MSGW_Printf(w, "NCS%s,%d,%d,", mtype, cf_lora_unitid, SendMsgCount++);
+  return (w->len);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaFrameSend() - Fill in length and checksum of the message written by w and send it
+ * 
+ *   lora_crc=0  CS is the 16 bit sum of the bytes after it
+ *   lora_crc=1  CS is CRC-16/CCITT-FALSE of the bytes after it, See crc.h
+ * =======================================================================================================================
+ */
+bool LoRaFrameSend(MSGW *w, int prio) {
+  unsigned short checksum;
+  int msgLength = w->len;
+  bool defer;
+
+  if (w->overflow || (msgLength > LORA_MAX_MSGLEN)) {
+    Output("LoRa Msg too large");
+    return (false);
+  }
+
+  // Compute checksum
+  if (cf_lora_crc) {
+    checksum = crc16((byte *) msgbuf+3, msgLength-3);
+  }
+  else {
+    checksum=0;
+    for(int i=3;i<msgLength;i++) {
+       checksum += (byte) msgbuf[i];
+    }
+  }
+  
+  msgbuf[0] = msgLength;
+  msgbuf[1] = checksum >> 8;
+  msgbuf[2] = checksum % 256;
+
+  defer = LoRaTxDefer(prio, msgLength);
+  if (defer && (prio == LORA_PRIO_N2S)) {
+    return (false);  // Left in N2S for the next replay
+  }
+  else if (defer && LoRaTxWhole) {
+    return (false);  // Part of a message that goes whole or not at all
+  }
+  else if (defer) {
+    return (LoRaTxQueueAdd(prio, msgbuf, msgLength));
   }
+  return (SendLoraAESMsg (msgbuf, msgLength, prio));
 }
 
 /*
@@ -148,46 +1076,278 @@ void SendLoraAESMsg (int bits, char *msg, int msgLength)
  *   OBS    JSON Observation
  * =======================================================================================================================
  */
-void SendLoRaMessage(char *ops, const char *mtype) {
-  int msgLength;
-  unsigned short checksum;
+bool SendLoRaMessage(const char *ops, const char *mtype) {
+  MSGW w;
+
+  // Build LoRa message, observations in JSON format
+  LoRaFrameHeader(&w, mtype);
+  MSGW_Str(&w, ops);
+
+  if (strcmp(mtype, "IF") == 0) {
+    return (LoRaTextSend(&w, LORA_PRIO_LOW));
+  }
+  return (LoRaTextSend(&w, (strcmp(mtype, "TQ") == 0) ? LORA_PRIO_EVENT : LORA_PRIO_HIGH));
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaTextSend() - Show the text LoRa message written by w on the console and send it
+ * =======================================================================================================================
+ */
+bool LoRaTextSend(MSGW *w, int prio) {
+  sprintf (Buffer32Bytes, "OBS MSG LEN[%d]", w->len);
+  Output (Buffer32Bytes);
+
+  // Let serial console see this LoRa message
+  Serial_write (msgbuf);
+
+  return (LoRaFrameSend(w, prio));
+}
+
+/*
+ * =======================================================================================================================
+ * SendLoRaFrame() - Send LoRa Binary Message
+ * 
+ *   NCS    Length (N) and Checksum (CS)
+ *   MT,    Message Type, LB
+ *   INT,   Station ID
+ *   INT,   Transmit Counter
+ *   BYTES  Binary payload, may contain 0x00
+ * =======================================================================================================================
+ */
+bool SendLoRaFrame(const byte *payload, int len, const char *mtype) {
+  MSGW w;
 
   // Build LoRa message
-  strcpy (msgbuf, "NCS");                 // N will be replaced with binary value (byte) representing (string length - 1)
-                                          //    This is how we can send variable length AES encrypted strings
-                                          //    The receiving side need to know characters folling this first byte
-                                          // CS is the place holder for the Checksum
-  // Message type
-  sprintf (msgbuf+strlen(msgbuf), "%s,", mtype); //  LoRa Remote Message Type
+  LoRaFrameHeader(&w, mtype);
+  MSGW_Mem(&w, payload, len);
 
-  // Station ID
-  sprintf (msgbuf+strlen(msgbuf), "%d,", cf_lora_unitid);    // Must be unique if multiple are transmitting
+  sprintf (Buffer32Bytes, "BIN MSG LEN[%d]", w.len);
+  Output (Buffer32Bytes);
 
-  // Transmit Counter
-  sprintf (msgbuf+strlen(msgbuf), "%d,", SendMsgCount++);
+  return (LoRaFrameSend(&w, LORA_PRIO_HIGH));
+}
 
-  // Observations in JSON format
-  sprintf (msgbuf+strlen(msgbuf), "%s", ops);
+/*
+ * =======================================================================================================================
+ * SendLoRaN2S() - Send a message from the Need to Send queue, flagged as such in the RadioHead header
+ *                 Returns true when the record is done with, sent or one that can never be sent
+ * =======================================================================================================================
+ */
+bool SendLoRaN2S(const byte *payload, int len, const char *mtype) {
+  MSGW w;
+  bool sent;
 
-  msgLength = strlen(msgbuf);
+  LoRaFrameHeader(&w, mtype);
+  MSGW_Mem(&w, payload, len);
 
-  sprintf (Buffer32Bytes, "OBS MSG LEN[%d]", msgLength);
+  sprintf (Buffer32Bytes, "N2S MSG LEN[%d]", w.len);
   Output (Buffer32Bytes);
-  
-  // Compute checksum
-  checksum=0;
-  for(int i=3;i<msgLength;i++) {
-     checksum += msgbuf[i];
+
+  // Would stop the queue at this record for good
+  if (w.overflow || !LoRaFrameFits(w.len)) {
+    Output ("N2S:SKIP, TOO LARGE");
+    return (true);
   }
 
-  // Let serial console see this LoRa message
-  Serial_write (msgbuf);
-  
-  msgbuf[0] = msgLength;
-  msgbuf[1] = checksum >> 8;
-  msgbuf[2] = checksum % 256;
-   
-  SendLoraAESMsg (128, msgbuf, msgLength);
+  rf95.setHeaderFlags(LORA_FLAG_N2S, 0);
+  sent = LoRaFrameSend(&w, LORA_PRIO_N2S);
+  rf95.setHeaderFlags(0, LORA_FLAG_N2S);
+  return (sent);
+}
+
+/*
+ * =======================================================================================================================
+ * SendLoRaFragmented() - Send message once, split across LF messages. See lora.h
+ *                        LoRaTxHeld is set when the message was held back whole, the caller tries again later
+ * =======================================================================================================================
+ */
+bool SendLoRaFragmented(const char *msg, int len, int prio) {
+  bool sent = true;
+  MSGW w;
+  int fragcnt = (len + LORA_FRAG_SPACE - 1) / LORA_FRAG_SPACE;
+  int chunk;
+  unsigned long airtime = 0;
+
+  if ((len <= 0) || (fragcnt > LORA_FRAG_MAX)) {
+    Output("LoRa Frag too large");
+    return (false);
+  }
+
+  // Fragments queued one by one would lose the tail, the message goes whole now or not at all
+  for (int f=0; f<fragcnt; f++) {
+    chunk = ((len - (f * LORA_FRAG_SPACE)) > LORA_FRAG_SPACE) ? LORA_FRAG_SPACE : (len - (f * LORA_FRAG_SPACE));
+    airtime += LoRaMsgAirtime(chunk + LORA_MAX_MSGLEN - LORA_FRAG_SPACE);
+  }
+  LoRaTxHeld = LoRaTxDeferAirtime(prio, airtime);
+  if (LoRaTxHeld) {
+    sprintf (Buffer32Bytes, "LoRa Frag Held %lums", airtime);
+    Output (Buffer32Bytes);
+    return (false);
+  }
+
+  LoRaTxWhole = true;
+  FragMsgId++;
+  for (int f=0; f<fragcnt; f++) {
+    chunk = ((len - (f * LORA_FRAG_SPACE)) > LORA_FRAG_SPACE) ? LORA_FRAG_SPACE : (len - (f * LORA_FRAG_SPACE));
+
+    // Build LoRa message
+    LoRaFrameHeader(&w, "LF");
+    MSGW_Printf(&w, "%d,%d,%d,", FragMsgId, f, fragcnt);
+    MSGW_Mem(&w, msg + (f * LORA_FRAG_SPACE), chunk);
+
+    sprintf (Buffer32Bytes, "LF MSG LEN[%d] %d/%d", w.len, f+1, fragcnt);
+    Output (Buffer32Bytes);
+
+    if (!LoRaFrameSend(&w, prio)) {
+      sent = false;
+      break;  // The gateway can not put the message together without it
+    }
+  }
+  LoRaTxWhole = false;
+  return (sent);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaRelaySeenCheck() - Return true if from and id was heard recently, else remember it
+ * =======================================================================================================================
+ */
+bool LoRaRelaySeenCheck(uint8_t from, uint8_t id) {
+  uint16_t key = ((uint16_t) from << 8) | id;
+
+  for (int i=0; i<LoRaRelaySeenCount; i++) {
+    if (LoRaRelaySeen[i] == key) {
+      return (true);
+    }
+  }
+  LoRaRelaySeen[LoRaRelaySeenNext] = key;
+  LoRaRelaySeenNext = (LoRaRelaySeenNext + 1) % LORA_RELAY_SEEN;
+  if (LoRaRelaySeenCount < LORA_RELAY_SEEN) {
+    LoRaRelaySeenCount++;
+  }
+  return (false);
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaRelayListen() - Listen ms for neighbor frames to the gateway and queue them to forward. See lora.h
+ * =======================================================================================================================
+ */
+void LoRaRelayListen(unsigned long ms) {
+  LORA_RELAY_FRAME *f;
+  byte buf[RH_RF95_MAX_MESSAGE_LEN];
+  uint8_t len;
+  uint8_t from;
+  uint8_t flags;
+  unsigned long start;
+  unsigned long elapsed;
+
+  if (!LORA_exists || !ms) {
+    return;
+  }
+
+  sprintf (Buffer32Bytes, "LoRa Relay Listen %lus", ms / 1000);
+  Output (Buffer32Bytes);
+
+  LoRaTxWait();               // Our last message has to be off air
+  rf95.setPromiscuous(true);  // Neighbor frames are addressed to the gateway, not us
+  start = millis();
+
+  while ((elapsed = millis() - start) < ms) {
+    // RadioHead takes a uint16_t timeout, longer windows are listened to in 65535 ms pieces
+    if (!rf95.waitAvailableTimeout(((ms - elapsed) > 65535UL) ? 65535 : (uint16_t) (ms - elapsed))) {
+      continue;
+    }
+    len = sizeof(buf);
+    if (!rf95.recv(buf, &len)) {
+      continue;
+    }
+    from  = rf95.headerFrom();
+    flags = rf95.headerFlags() & RH_FLAGS_APPLICATION_SPECIFIC;
+    if ((rf95.headerTo() != cf_lora_gwid) || (from == cf_lora_unitid) || (from == cf_lora_gwid)) {
+      continue;  // Not a unit to gateway frame, or our own relayed back
+    }
+    if (LoRaRelaySeenCheck(from, rf95.headerId())) {
+      LoRaRelayDups++;
+      continue;
+    }
+    if (((flags & LORA_FLAG_HOPS) >= LORA_RELAY_HOPS) || (LoRaRelayCount >= LORA_RELAY_QUEUE)) {
+      LoRaRelayDrops++;
+      sprintf (Buffer32Bytes, "LoRa Relay Drop %d", from);
+      Output (Buffer32Bytes);
+      continue;
+    }
+
+    f = &LoRaRelayQueue[LoRaRelayCount++];
+    f->from  = from;
+    f->id    = rf95.headerId();
+    f->flags = flags;
+    f->len   = len;
+    memcpy (f->buf, buf, len);
+    LoRaRelayHeard++;
+
+    sprintf (Buffer32Bytes, "LoRa Relay Heard %d,%d", from, rf95.lastRssi());
+    Output (Buffer32Bytes);
+  }
+
+  LoRaRelayListenTime += millis() - start;
+  rf95.setPromiscuous(false);
+  rf95.setModeIdle();  // Leave receive
+}
+
+/*
+ * =======================================================================================================================
+ * LoRaRelayForward() - Send the queued neighbor frames as received, hop count up by one
+ * =======================================================================================================================
+ */
+void LoRaRelayForward() {
+  LORA_RELAY_FRAME *f;
+  unsigned long airtime;
+  uint32_t t;
+
+  if (!LORA_exists || !LoRaRelayCount) {
+    return;
+  }
+
+  for (int i=0; i<LoRaRelayCount; i++) {
+    f = &LoRaRelayQueue[i];
+
+    // Low priority, the last quarter of the budget is kept for our own observations
+    airtime = LoRaAirtime(f->len + RH_RF95_HEADER_LEN);
+    t = LoRaDCTime();
+    if (!LoRaDCCheck(t, airtime, LORA_PRIO_LOW)) {
+      LoRaDCDrops++;
+      LoRaRelayDrops++;
+      sprintf (Buffer32Bytes, "LoRa Relay DC Drop %d", f->from);
+      Output (Buffer32Bytes);
+      continue;
+    }
+
+    LoRaTxSpacing();
+
+    if (cf_lora_lbt && !LoRaChannelClear()) {
+      Output ("LoRa LBT Busy, Sending");
+    }
+
+    rf95.setHeaderFrom(f->from);
+    rf95.setHeaderId(f->id);
+    rf95.setHeaderFlags((f->flags & ~(LORA_FLAG_ACKREQ | LORA_FLAG_HOPS)) | ((f->flags & LORA_FLAG_HOPS) + 1), 
+      RH_FLAGS_APPLICATION_SPECIFIC);
+    rf95.send(f->buf, f->len);  // Returns while on air, header is already in the radio FIFO
+    LoRaNextTx = millis() + airtime + constrain(airtime, LORA_IFS_MIN, LORA_IFS_MAX);
+    LoRaDCAdd(t, airtime);
+    LoRaRelayAirtime += airtime;
+    LoRaRelayForwarded++;
+
+    sprintf (Buffer32Bytes, "LoRa Relay Sent %d %lums", f->from, airtime);
+    Output (Buffer32Bytes);
+  }
+  LoRaRelayCount = 0;
+
+  // Back to our own header
+  rf95.setHeaderFrom(cf_lora_unitid);
+  rf95.setHeaderFlags((cf_lora_ack) ? LORA_FLAG_ACKREQ : 0, RH_FLAGS_APPLICATION_SPECIFIC);
 }
 
 /* 
@@ -227,6 +1387,7 @@ bool lora_cf_validate() {
   else { 
     memcpy ((char *)AES_KEY, cf_aes_pkey, 16);
     sprintf(msgbuf, "AES_KEY[%s]", cf_aes_pkey); Output (msgbuf);
+    aes.set_key(AES_KEY, 128);  // Expand the key schedule once, it does not change
 
     AES_MYIV=cf_aes_myiv;
     sprintf(msgbuf, "AES_MYIV[%u]", AES_MYIV); Output (msgbuf);
@@ -262,6 +1423,60 @@ void lora_initialize() {
     // Node ID of where we're sending packets
     rf95.setHeaderTo(cf_lora_gwid);
 
+    // Backoff jitter, different per unit and boot
+    randomSeed(rtc.now().unixtime() ^ ((uint32_t) cf_lora_unitid << 24));
+
+    // Ask the gateway to ACK our messages
+    if (cf_lora_ack) {
+      rf95.setHeaderFlags(LORA_FLAG_ACKREQ, 0);
+    }
+
+    // Relay listens on one channel, neighbors hop
+    if (cf_lora_channels && cf_lora_relay) {
+      cf_lora_relay = 0;
+      Output ("LoRa Relay Off, Hopping");
+    }
+
+    // Hopping, ADR stops at the highest SF a full frame fits the dwell time. CBC pads a full message
+    // to the next block, CTR adds the nonce, the larger of the two
+    if (cf_lora_channels) {
+      while ((LoRaSFMax > LORA_SF_MIN) && (LoRaAirtimeSF((((LORA_MAX_MSGLEN / N_BLOCK) + 1) * N_BLOCK) + 
+          RH_RF95_HEADER_LEN, LoRaSFMax) > LORA_DWELL_MAX)) {
+        LoRaSFMax--;
+      }
+      sprintf (Buffer32Bytes, "LoRa Hop SF Max %d", LoRaSFMax);
+      Output (Buffer32Bytes);
+    }
+
+    // LoRa settings kept in EEPROM
+    if (!EEPROM_LoRaRead()) {
+      // Lost, not just never written, the boot count and the CTR epochs used are unknown
+      bool lost = eeprom_exists && !EEPROM_LoRaBlank();
+
+      memset(&eeprom_lora, 0, sizeof(eeprom_lora));
+      eeprom_lora.sf = LoRaSF;
+      eeprom_lora.noctr = lost;
+      EEPROM_LoRaUpdate();
+    }
+
+    // Restore the Spreading Factor ADR last picked from an ACK
+    LoRaSFConf = LoRaSF;
+    if (cf_lora_adr && (eeprom_lora.sf >= LORA_SF_MIN) && (eeprom_lora.sf <= LoRaSFMax)) {
+      LoRaSetSF(eeprom_lora.sf);
+    }
+
+    // CTR nonce needs a boot count that survives power off, else a nonce would repeat
+    if (cf_lora_cipher == LORA_CIPHER_CTR) {
+      if (eeprom_exists && !eeprom_lora.noctr && (eeprom_lora.bootcnt != 0xFFFF)) {
+        eeprom_lora.bootcnt++;
+        EEPROM_LoRaUpdate();
+      }
+      else {
+        cf_lora_cipher = LORA_CIPHER_CBC;
+        Output ((eeprom_exists) ? "LoRa CTR EEPROM Lost, CBC" : "LoRa CTR !EEPROM, CBC");
+      }
+    }
+
     LORA_exists = true;
     Output ("LORA OK");
     
@@ -0,0 +1,176 @@
+/*
+ * ======================================================================================================================
+ *  msgw.cpp - Message Writer Functions
+ * ======================================================================================================================
+ */
+#include <Arduino.h>
+#include <stdarg.h>
+
+#include "include/msgw.h"
+
+/*
+ * ======================================================================================================================
+ * Fuction Definations
+ * =======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ * MSGW_Init() - Start an empty message in buf
+ * ======================================================================================================================
+ */
+void MSGW_Init(MSGW *w, char *buf, int size) {
+  w->buf = buf;
+  w->size = size;
+  w->len = 0;
+  w->overflow = false;
+  w->buf[0] = 0;
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Mem() - Append n bytes, may contain 0x00
+ * ======================================================================================================================
+ */
+void MSGW_Mem(MSGW *w, const void *data, int n) {
+  int room = w->size - 1 - w->len;
+
+  if (n > room) {
+    n = room;
+    w->overflow = true;
+  }
+  memcpy (w->buf + w->len, data, n);
+  w->len += n;
+  w->buf[w->len] = 0;
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Str() - Append string
+ * ======================================================================================================================
+ */
+void MSGW_Str(MSGW *w, const char *s) {
+  MSGW_Mem(w, s, strlen(s));
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Char() - Append character
+ * ======================================================================================================================
+ */
+void MSGW_Char(MSGW *w, char c) {
+  if ((w->len + 1) < w->size) {
+    w->buf[w->len++] = c;
+    w->buf[w->len] = 0;
+  }
+  else {
+    w->overflow = true;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Printf() - Append formatted, as sprintf
+ * ======================================================================================================================
+ */
+void MSGW_Printf(MSGW *w, const char *fmt, ...) {
+  int room = w->size - w->len;
+  int n;
+  va_list ap;
+
+  va_start(ap, fmt);
+  n = vsnprintf(w->buf + w->len, room, fmt, ap);
+  va_end(ap);
+
+  if (n < 0) {
+    w->buf[w->len] = 0;
+    w->overflow = true;
+  }
+  else if (n >= room) {
+    w->len = w->size - 1;   // vsnprintf wrote what fit
+    w->overflow = true;
+  }
+  else {
+    w->len += n;
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Fmt() - Write v with dp decimals into out[MSGW_FMT_LEN], return out. See msgw.h
+ * ======================================================================================================================
+ */
+char *MSGW_Fmt(char *out, float v, int dp) {
+  static const uint32_t scale[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+  char tmp[MSGW_FMT_LEN];
+  uint32_t bits;
+  uint32_t m;
+  uint64_t q;
+  int e;
+  int n = 0;
+  int ndigits = (dp) ? dp + 2 : 1;   // Smallest result without sign, "0" or "0.00"
+
+  memcpy (&bits, &v, sizeof(bits));
+  e = (bits >> 23) & 0xFF;
+  m = bits & 0x7FFFFF;
+
+  if ((dp < 0) || (dp > 6) || (e == 0xFF) || (fabsf(v) >= 1e9)) {
+    snprintf (out, MSGW_FMT_LEN, "%.*f", (dp < 0) ? 0 : dp, v);
+    return (out);
+  }
+
+  // v = m * 2^e
+  if (e == 0) {
+    e = 1;            // Subnormal
+  }
+  else {
+    m |= 0x800000;    // Hidden bit
+  }
+  e -= 150;
+
+  // q = v * 10^dp rounded, m * 10^6 < 2^44 and |v| < 1e9 keeps a left shift under 2^51
+  q = (uint64_t) m * scale[dp];
+  if (e >= 0) {
+    q <<= e;
+  }
+  else if (e < -63) {
+    q = 0;            // Under 2^-20, rounds to 0 at any dp
+  }
+  else {
+    uint64_t rem  = q & ((1ULL << -e) - 1);
+    uint64_t half = 1ULL << (-e - 1);
+
+    q >>= -e;
+    if ((rem > half) || ((rem == half) && (q & 1))) {
+      q++;
+    }
+  }
+
+  // Digits least significant first, at least one before the point
+  do {
+    tmp[n++] = '0' + (q % 10);
+    q /= 10;
+    if (n == dp) {
+      tmp[n++] = '.';
+    }
+  } while (q || (n < ndigits));
+  if (bits & 0x80000000) {
+    tmp[n++] = '-';
+  }
+  for (int i=0; i<n; i++) {
+    out[i] = tmp[n-1-i];
+  }
+  out[n] = 0;
+  return (out);
+}
+
+/*
+ * ======================================================================================================================
+ * MSGW_Fixed() - Append v with dp decimals, as MSGW_Printf() "%.*f"
+ * ======================================================================================================================
+ */
+void MSGW_Fixed(MSGW *w, float v, int dp) {
+  char f[MSGW_FMT_LEN];
+
+  MSGW_Str(w, MSGW_Fmt(f, v, dp));
+}
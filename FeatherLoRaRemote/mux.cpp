@@ -8,6 +8,7 @@
 #include <i2cArduino.h>
 #include "include/qc.h"
 #include "include/obs.h"
+#include "include/obsreg.h"
 #include "include/sensors.h"
 #include "include/output.h"
 #include "include/support.h"
@@ -24,6 +25,8 @@ MULTIPLEXER_STR mux[MUX_CHANNELS];
 MULTIPLEXER_STR *mc;
 CH_SENSOR *chs;
 const char *sensor_type[] = {"UNKN", "bmp", "bme", "b38", "b39", "htu", "sht", "mcp", "hdc", "lps", "hih", "tlw", "tsm", "si"};
+bool mux_triggered = false;
+unsigned long mux_trigger_ms = 0;  // millis() when TSM readings were started
 
 /*
  * ======================================================================================================================
@@ -59,12 +62,53 @@ void mux_channel_set(uint8_t channel) {
   Wire.endTransmission();  
 }
   
+/* 
+ *=======================================================================================================================
+ * mux_trigger() - Start a reading on every TSM, on the mux or the main bus, mux_obs_do() collects them
+ *                 The TSMs convert together, one TSM_READING_MS wait covers them all
+ *=======================================================================================================================
+ */
+void mux_trigger() {
+  int n = 0;
+
+  if (MUX_exists) {
+    for (int c=0; c<MUX_CHANNELS; c++) {
+      if (mux[c].inuse) {
+        mux_channel_set(c);
+        for (int s = 0; s < MAX_CHANNEL_SENSORS; s++) {
+          if (mux[c].sensor[s].type == m_tsm) {
+            tinovi_start(TSM_ADDRESS, REG_READ_START);
+            n++;
+          }
+        }
+      }
+    }
+    mux_deselect_all();
+  }
+  else if (TSM_exists) {
+    tinovi_start(TSM_ADDRESS, REG_READ_START);
+    n++;
+  }
+  if (n) {
+    mux_trigger_ms = millis();
+    mux_triggered = true;
+  }
+}
+
 /* 
  *=======================================================================================================================
  * mux_obs_do() - do obs for mux devices
  *=======================================================================================================================
  */
 void mux_obs_do(int &sidx) {
+  if (!mux_triggered) {
+    mux_trigger();
+  }
+  if (mux_triggered) {
+    DelaySince(mux_trigger_ms, TSM_READING_MS);
+    mux_triggered = false;
+  }
+
   if (MUX_exists) {
     Output("MUX:OBSDO");
  
@@ -75,31 +119,19 @@ void mux_obs_do(int &sidx) {
 
           // Tinovi Soil Moisture
           if (mux[c].sensor[s].type == m_tsm) {
-            tsm.newReading();
-            delay(100);
-            
-            sprintf (obs.sensor[sidx].id, "tsme25-%d", mux[c].sensor[s].id);
-            obs.sensor[sidx].type = F_OBS;
-            obs.sensor[sidx].f_obs = tsm.getE25();
-            obs.sensor[sidx++].inuse = true;
-
-            sprintf (obs.sensor[sidx].id, "tsmec-%d", mux[c].sensor[s].id);
-            obs.sensor[sidx].type = F_OBS;
-            obs.sensor[sidx].f_obs = tsm.getEC();
-            obs.sensor[sidx++].inuse = true;
-
-            sprintf (obs.sensor[sidx].id, "tsmvwc-%d", mux[c].sensor[s].id);
-            obs.sensor[sidx].type = F_OBS;
-            obs.sensor[sidx].f_obs = tsm.getVWC();
-            obs.sensor[sidx++].inuse = true;
-            
-            float t = tsm.getTemp();
-            t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-            
-            sprintf (obs.sensor[sidx].id, "tsmt-%d", mux[c].sensor[s].id);
-            obs.sensor[sidx].type = F_OBS;
-            obs.sensor[sidx].f_obs = t;
-            obs.sensor[sidx++].inuse = true;
+            // Registry has rows for TSM ids 1-8, 4 rows each
+            int id = mux[c].sensor[s].id;
+            if ((id >= 1) && (id <= 8)) {
+              int reg = OBSREG_TSME25_1 + (id-1)*4;
+              OBS_Add (sidx, reg,   tsm.getE25());
+              OBS_Add (sidx, reg+1, tsm.getEC());
+              OBS_Add (sidx, reg+2, tsm.getVWC());
+              OBS_Add (sidx, reg+3, tsm.getTemp());
+            }
+            else {
+              sprintf (Buffer32Bytes, "TSM%d NO REG", id);
+              Output (Buffer32Bytes);
+            }
           } // Tinovi Soil Moisture
         } // for
       } // in use
@@ -109,31 +141,10 @@ void mux_obs_do(int &sidx) {
   else {
     // No MUX so check main i2c bus for Sensor
     if (TSM_exists) {
-      tsm.newReading();
-      delay(100);
-
-      sprintf (obs.sensor[sidx].id, "tsme25");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = tsm.getE25();
-      obs.sensor[sidx++].inuse = true;
-
-      sprintf (obs.sensor[sidx].id, "tsmec");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = tsm.getEC();
-      obs.sensor[sidx++].inuse = true;
-
-      sprintf (obs.sensor[sidx].id, "tsmvwc");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = tsm.getVWC();
-      obs.sensor[sidx++].inuse = true;
-            
-      float t = tsm.getTemp();
-      t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-            
-      sprintf (obs.sensor[sidx].id, "tsmt");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = t;
-      obs.sensor[sidx++].inuse = true;        
+      OBS_Add (sidx, OBSREG_TSME25, tsm.getE25());
+      OBS_Add (sidx, OBSREG_TSMEC, tsm.getEC());
+      OBS_Add (sidx, OBSREG_TSMVWC, tsm.getVWC());
+      OBS_Add (sidx, OBSREG_TSMT, tsm.getTemp());
     } // TSM
   } // No MUX
 }
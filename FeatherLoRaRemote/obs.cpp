@@ -11,6 +11,9 @@
  *  Overhead = 110
  *  LoRa Payload 222 bytes when using typical settings like Spreading Factor 7 and 125 kHz bandwidth
  *  RadioHead RF95 library is typically using Spreading Factor = 7.
+ *
+ *  LR messages are filled by OBS_Pack(), sensors are placed largest first into the first message with room,
+ *  up to LORA_MAX_MSGLEN. Sensor order within a message is kept, the order across messages is not.
  * ======================================================================================================================
  */
 //#include <Arduino.h>
@@ -30,12 +33,15 @@
 #include "include/cf.h"
 #include "include/sdcard.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/lora.h"
 #include "include/support.h"
 #include "include/gps.h"
 #include "include/time.h"
 #include "include/main.h"
+#include "include/obsbin.h"
 #include "include/obs.h"
+#include "include/obsreg.h"
 
 /*
  * ======================================================================================================================
@@ -44,6 +50,25 @@
  */
 OBSERVATION_STR obs;
 float bmx_1_pressure = 0.0;
+uint32_t obs_sendtime = 0;   // When slotted, unix time to send the observation taken, 0 = nothing pending
+
+// obs_batch, LM message being built. See obsbin.h
+byte obs_batch_msg[OBSBIN_SPACE];
+int obs_batch_len = 0;                 // 0 = no LM message started
+int obs_batch_count = 0;               // Observations in the LM message
+time_t obs_batch_ts = 0;               // Time of the last observation added
+uint8_t obs_batch_ptag[MAX_SENSORS];   // Tags and scaled values of the last observation added, delta base
+int32_t obs_batch_pval[MAX_SENSORS];
+int obs_batch_pcnt = 0;
+
+// obs_format=3, last delivered observation the LD deltas are against. See obsbin.h
+uint8_t obs_delta_tag[MAX_SENSORS];
+int32_t obs_delta_val[MAX_SENSORS];
+int obs_delta_cnt = 0;
+time_t obs_delta_ts = 0;               // 0 = no baseline, send a keyframe
+int obs_delta_since = 0;               // Observations since the last delivered keyframe
+
+unsigned long obs_tlw_ms = 0;          // millis() when the TLW reading was started, See OBS_Trigger()
 
 /*
  * ======================================================================================================================
@@ -63,74 +88,287 @@ void OBS_Clear() {
   }
 }
 
+/*
+ * ======================================================================================================================
+ * OBS_RamReport() - Log the RAM held by the observation structure
+ * ======================================================================================================================
+ */
+void OBS_RamReport() {
+  sprintf (Buffer32Bytes, "OBS RAM:%d %dx%d", (int) sizeof(obs), MAX_SENSORS, (int) sizeof(SENSOR));
+  Output (Buffer32Bytes);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Pack() - Place n fields of len[] bytes into the fewest messages of space bytes, First Fit Decreasing.
+ *              Message index of each field is returned in pkt[], return is the number of messages.
+ * ======================================================================================================================
+ */
+int OBS_Pack(const uint8_t *len, uint8_t *pkt, int n, int space) {
+  uint8_t order[MAX_SENSORS];
+  int pktfree[MAX_SENSORS];
+  int npkts = 0;
+  int i, j, p;
+
+  // Order fields largest first, n is small so insertion sort
+  for (i=0; i<n; i++) {
+    uint8_t f = i;
+    for (j=i; (j>0) && (len[order[j-1]] < len[f]); j--) {
+      order[j] = order[j-1];
+    }
+    order[j] = f;
+  }
+
+  // Each field goes in the first message with room, else start a new message
+  for (i=0; i<n; i++) {
+    uint8_t f = order[i];
+    for (p=0; (p<npkts) && (pktfree[p] < len[f]); p++);
+    if (p == npkts) {
+      pktfree[npkts++] = space;
+    }
+    pkt[f] = p;
+    pktfree[p] -= len[f];
+  }
+  return (npkts);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_BatchFlush() - Send the LM message if it has observations, queue to N2S if it was not sent
+ * ======================================================================================================================
+ */
+bool OBS_BatchFlush() {
+  bool sent = true;
+
+  if (obs_batch_len > OBSBIN_HEADER) {
+    sprintf (Buffer32Bytes, "OBS LM:%d OBS:%d", obs_batch_len, obs_batch_count);
+    Output (Buffer32Bytes);
+    if (!SendLoRaFrame(obs_batch_msg, obs_batch_len, "LM")) {
+      SD_N2S_Append("LM", obs_batch_msg, obs_batch_len);
+      sent = false;
+    }
+  }
+  obs_batch_len = 0;
+  obs_batch_count = 0;
+  obs_batch_pcnt = 0;
+  return (sent);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Batch() - Add an observation to the LM message, send it when it holds obs_batch observations
+ *               tag[] and val[] are obsbin tag indexes and scaled values. Returns false if a LM was not sent
+ * ======================================================================================================================
+ */
+bool OBS_Batch(time_t ts, const uint8_t *tag, const int32_t *val, int n) {
+  bool sent = true;
+  byte blk[OBSBIN_SPACE];
+  int blen;
+  int cntofs;
+  int r;
+  int32_t base;
+
+  for (;;) {
+    if (obs_batch_len == 0) {
+      obs_batch_len = obsbin_header(obs_batch_msg, ts);
+      obs_batch_ts = ts;
+    }
+
+    // Encode the block against the previous observation, a record is at most 6 bytes
+    blen = obsbin_put_varint(blk, (int32_t)(ts - obs_batch_ts));
+    cntofs = blen++;
+    for (r=0; r<n; r++) {
+      if ((obs_batch_len + blen + 6) > OBSBIN_SPACE) {
+        break;
+      }
+      base = 0;
+      for (int p=0; p<obs_batch_pcnt; p++) {
+        if (obs_batch_ptag[p] == tag[r]) {
+          base = obs_batch_pval[p];
+          break;
+        }
+      }
+      blk[blen++] = tag[r];
+      blen += obsbin_put_varint(blk+blen, val[r] - base);
+    }
+    blk[cntofs] = r;
+
+    // All fit, or the message is empty and this is as much as will ever fit
+    if ((r == n) || (obs_batch_count == 0)) {
+      break;
+    }
+
+    // Send what we have, this observation starts the next LM message
+    if (!OBS_BatchFlush()) {
+      sent = false;
+    }
+  }
+
+  if (r < n) {
+    sprintf (Buffer32Bytes, "OBS LM DROP:%d", n - r);
+    Output (Buffer32Bytes);
+  }
+
+  memcpy (obs_batch_msg + obs_batch_len, blk, blen);
+  obs_batch_len += blen;
+  memcpy (obs_batch_ptag, tag, r);
+  memcpy (obs_batch_pval, val, r * sizeof(int32_t));
+  obs_batch_pcnt = r;
+  obs_batch_ts = ts;
+  obs_batch_count++;
+
+  if (obs_batch_count >= cf_obs_batch) {
+    if (!OBS_BatchFlush()) {
+      sent = false;
+    }
+  }
+  return (sent);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_DeltaBase() - Return the baseline scaled value of tag for LD, 0 if not in the baseline
+ * ======================================================================================================================
+ */
+int32_t OBS_DeltaBase(uint8_t tag) {
+  for (int b=0; b<obs_delta_cnt; b++) {
+    if (obs_delta_tag[b] == tag) {
+      return (obs_delta_val[b]);
+    }
+  }
+  return (0);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_BinHeader() - Put the LB header, or the LD header and baseline age, into buf. Return bytes used
+ * ======================================================================================================================
+ */
+int OBS_BinHeader(byte *buf, bool keyframe) {
+  int n = obsbin_header(buf, obs.ts);
+
+  if (cf_obs_format == OBS_FORMAT_DELTA) {
+    n += obsbin_put_varint(buf+n, (keyframe) ? 0 : (int32_t)(obs.ts - obs_delta_ts));
+  }
+  return (n);
+}
+
 /*
  * ======================================================================================================================
  * OBS_Send() - From obs structure build a JSON and send 1 or more LoRa packets as needed
+ *              With obs_format=1 the LoRa packets are binary LB messages, See obsbin.h
+ *              With obs_format=2 the JSON is sent once as fragmented LF messages, See lora.h
+ *              With obs_format=3 the LoRa packets are LB with deltas against the last delivered, LD, See obsbin.h
+ *              With obs_batch>1 observations are held and sent together as LM messages, See obsbin.h
  * ======================================================================================================================
  */
 void OBS_Send() {
   char header[128];
-  char sensors[128];
-  char sensor[16];
-  char loramsg[256];
   char obslog[1024];   // Holds JSON observations to write to log
+  MSGW hw;             // Writes header
+  MSGW lw;             // Writes obslog
+  MSGW mw;             // Writes the LR message in msgbuf
+  int mhdr;            // Bytes of LoRa header in msgbuf
+  byte binmsg[OBSBIN_SPACE];
+  int binlen = 0;
+  int binhdr = 0;      // Bytes of LB/LD header in binmsg
+  int bintotal = 0;
+  bool binfmt = (cf_obs_batch <= 1) && 
+    ((cf_obs_format == OBS_FORMAT_BINARY) || (cf_obs_format == OBS_FORMAT_DELTA));
+  const char *bintype = (cf_obs_format == OBS_FORMAT_DELTA) ? "LD" : "LB";
+  bool keyframe = false;
+  int lrtotal = 0;     // JSON bytes LR messages would have sent, obs_format=2
+  int fieldofs[MAX_SENSORS];     // Offset of each sensor in obslog
+  uint8_t fieldlen[MAX_SENSORS]; // Length of each sensor in obslog
+  uint8_t fieldpkt[MAX_SENSORS]; // LR message each sensor is placed in
+  int nfields = 0;
+  int npkts = 0;
+  unsigned long awake = millis();      // Time awake for this send cycle
+  unsigned long idle = LoRaTxIdle;     // Of which idle waiting on the radio
+  bool delivered = true;               // All LoRa messages for this observation sent
+  bool transmitted = true;             // LoRa messages were sent this observation
+  uint8_t btag[MAX_SENSORS];           // obs_batch and LD, tag indexes and scaled values
+  int32_t bval[MAX_SENSORS];
+  int bcnt = 0;
    
   Output("OBS_SEND()");
     
   if (obs.inuse) {     // Sanity check set by OBS_Take()
-    memset(header, 0, sizeof(header));
-    memset(sensors, 0, sizeof(sensors));
-    memset(obslog, 0, sizeof(obslog));
-    memset(loramsg, 0, sizeof(loramsg));
-
     // Observation will be in JSON format
-    // OBS_Take() has already obtained the time
+    // OBS_Take() has already obtained the time, use it as the timestamp can change before a slotted send
+    DateTime at = DateTime(obs.ts);
 
-    sprintf (header, "\"at\":\"%s\",\"id\":%d,\"devid\":\"%s\",\"mtype\":\"OBS\"", 
-      timestamp, cf_lora_unitid, DeviceID);
+    MSGW_Init(&hw, header, sizeof(header));
+    MSGW_Printf(&hw, "\"at\":\"%d-%02d-%02dT%02d:%02d:%02d\",\"id\":%d,\"devid\":\"%s\",\"mtype\":\"OBS\"", 
+      at.year(), at.month(), at.day(), at.hour(), at.minute(), at.second(), cf_lora_unitid, DeviceID);
 
-    sprintf (obslog, "{%s", header);
+    MSGW_Init(&lw, obslog, sizeof(obslog));
+    MSGW_Char(&lw, '{');
+    MSGW_Mem(&lw, header, hw.len);
+
+    if (binfmt) {
+      // LD keyframe when there is no baseline, it is too old or time went backwards
+      keyframe = (obs_delta_ts == 0) || (obs_delta_since >= cf_obs_keyframe) || (obs.ts <= obs_delta_ts);
+      binhdr = binlen = OBS_BinHeader(binmsg, keyframe);
+    }
     
     for (int s=0; s<MAX_SENSORS; s++) {
       if (obs.sensor[s].inuse) {
         // sprintf (Buffer32Bytes, "PROCESSOBS=%d", s);
         // Output(Buffer32Bytes);   
+
+        // Add the sensor to the obs log that we will later save to SD card
+        // Remember where it is so OBS_Pack() can place it into a LoRa message
+        fieldofs[nfields] = lw.len;
         switch (obs.sensor[s].type) {
           case F_OBS :
-            sprintf (sensor, ",\"%s\":%.1f", obs.sensor[s].id, obs.sensor[s].f_obs);
+            MSGW_Printf(&lw, ",\"%s\":", obs_registry[obs.sensor[s].tag].tag);
+            MSGW_Fixed(&lw, obs.sensor[s].f_obs, 1);
             break;
           case I_OBS :
-            sprintf (sensor, ",\"%s\":%d", obs.sensor[s].id, obs.sensor[s].i_obs);
+            MSGW_Printf(&lw, ",\"%s\":%d", obs_registry[obs.sensor[s].tag].tag, obs.sensor[s].i_obs);
             break;
           case U_OBS :
-            sprintf (sensor, ",\"%s\":%u", obs.sensor[s].id, obs.sensor[s].i_obs);
+            MSGW_Printf(&lw, ",\"%s\":%u", obs_registry[obs.sensor[s].tag].tag, obs.sensor[s].i_obs);
             break;
           default : // Should never happen
             Output ("WhyAmIHere?");
             break;
         }
-        
-        // Add the sensor to the obs log that we will later save to SD card
-        sprintf (obslog+strlen(obslog), "%s", sensor);
-        
-        // Will this Sensor observation fit into sensors
-        // OBS_SPACE is 112 bytes. This is how we do not overflow the 256 byte loramsg structure, sensors structure is 128 bytes
-        if ( (strlen(sensor) + strlen(sensors)) <= OBS_SPACE) {
-          // Add the sensor to the sensors
-          sprintf (sensors+strlen(sensors), "%s", sensor);
+        fieldlen[nfields] = lw.len - fieldofs[nfields];
+        nfields++;
+
+        if (cf_obs_batch > 1) {
+          uint8_t tidx = obs.sensor[s].tag;
+          btag[bcnt] = tidx;
+          bval[bcnt] = obsbin_scale(tidx, obs.sensor[s].f_obs, obs.sensor[s].i_obs, (obs.sensor[s].type == F_OBS));
+          bcnt++;
         }
-        else {       
-          // Put the parts together and send
-          Output("OBS_SEND:SENDING");
-          sprintf (loramsg, "{%s%s}", header, sensors);
-          SendLoRaMessage(loramsg, "LR");
-          delay(500); // Its Recommended before sending another message
-          Output("OBS_SEND:SENT");
-
-          // Clear sensors and add the one that would not fit
-          memset(sensors, 0, sizeof(sensors));
-          memset(loramsg, 0, sizeof(loramsg));
-          sprintf (sensors, "%s", sensor);
+        else if (binfmt) {
+          uint8_t tidx = obs.sensor[s].tag;
+
+          // Will this sensor record fit, a record is at most 6 bytes
+          if ((binlen + 6) > OBSBIN_SPACE) {
+            Output("OBS_SEND:SENDING");
+            if (!SendLoRaFrame(binmsg, binlen, bintype)) {
+              SD_N2S_Append(bintype, binmsg, binlen);
+              delivered = false;
+            }
+            bintotal += binlen;
+            Output("OBS_SEND:SENT");
+            binlen = OBS_BinHeader(binmsg, keyframe);
+          }
+          if (cf_obs_format == OBS_FORMAT_DELTA) {
+            btag[bcnt] = tidx;
+            bval[bcnt] = obsbin_scale(tidx, obs.sensor[s].f_obs, obs.sensor[s].i_obs, (obs.sensor[s].type == F_OBS));
+            binmsg[binlen++] = tidx;
+            binlen += obsbin_put_varint(binmsg+binlen, bval[bcnt] - ((keyframe) ? 0 : OBS_DeltaBase(tidx)));
+            bcnt++;
+          }
+          else {
+            binlen += obsbin_record(binmsg+binlen, tidx, obs.sensor[s].f_obs, obs.sensor[s].i_obs, 
+              (obs.sensor[s].type == F_OBS));
+          }
         }
       }
       else {
@@ -139,17 +377,101 @@ void OBS_Send() {
       }
     } // for
 
-    // Send remainding obs if any
-    if (strlen(sensors)) {
+    // Place the sensors into as few LR messages as will fit, then send them
+    if ((cf_obs_batch <= 1) && !binfmt && (nfields > 0)) {
+      npkts = OBS_Pack(fieldlen, fieldpkt, nfields, LORA_MAX_MSGLEN - OBS_LORA_HEADER - hw.len - 2);
+
+      for (int p=0; p<npkts; p++) {
+        if (cf_obs_format == OBS_FORMAT_FRAG) {
+          lrtotal += hw.len + 2;  // Sent as LF below
+          for (int f=0; f<nfields; f++) {
+            if (fieldpkt[f] == p) {
+              lrtotal += fieldlen[f];
+            }
+          }
+          continue;
+        }
+
+        // Write the LR message in place in msgbuf, no copies
+        mhdr = LoRaFrameHeader(&mw, "LR");
+        MSGW_Char(&mw, '{');
+        MSGW_Mem(&mw, header, hw.len);
+        for (int f=0; f<nfields; f++) {
+          if (fieldpkt[f] == p) {
+            MSGW_Mem(&mw, obslog+fieldofs[f], fieldlen[f]);
+          }
+        }
+        MSGW_Char(&mw, '}');
+
+        Output("OBS_SEND:SENDING");
+        if (!LoRaTextSend(&mw, LORA_PRIO_HIGH)) {
+          // JSON is still in msgbuf after the LoRa header
+          SD_N2S_Append("LR", (byte *) msgbuf + mhdr, mw.len - mhdr);
+          delivered = false;
+        }
+        Output("OBS_SEND:SENT");
+      }
+      sprintf (Buffer32Bytes, "OBS LR PKTS:%d FLDS:%d", npkts, nfields);
+      Output (Buffer32Bytes);
+    }
+
+    if (binlen > binhdr) {
       Output("OBS_SEND:SENDING-LAST");
-      sprintf (loramsg, "{%s%s}", header, sensors);
-      SendLoRaMessage(loramsg, "LR");
+      if (!SendLoRaFrame(binmsg, binlen, bintype)) {
+        SD_N2S_Append(bintype, binmsg, binlen);
+        delivered = false;
+      }
+      bintotal += binlen;
+    }
+
+    // Delivered observation is the new LD baseline, else keep the old one the gateway has
+    if (binfmt && (cf_obs_format == OBS_FORMAT_DELTA)) {
+      obs_delta_since++;
+      if (delivered) {
+        memcpy (obs_delta_tag, btag, bcnt);
+        memcpy (obs_delta_val, bval, bcnt * sizeof(int32_t));
+        obs_delta_cnt = bcnt;
+        obs_delta_ts = obs.ts;
+        if (keyframe) {
+          obs_delta_since = 0;
+        }
+      }
     }
     
     // Close off the observation and save to SD card
-    sprintf (obslog+strlen(obslog), "}"); 
+    MSGW_Char(&lw, '}');
+    if (lw.overflow) {
+      Output("OBS LOG TRUNC");
+    }
     SD_LogObservation(obslog);
+
+    if (cf_obs_batch > 1) {
+      delivered = OBS_Batch(obs.ts, btag, bval, bcnt);
+      transmitted = (obs_batch_count == 0);
+    }
+    else if (cf_obs_format == OBS_FORMAT_FRAG) {
+      Output("OBS_SEND:SENDING-FRAG");
+      delivered = SendLoRaFragmented(obslog, lw.len, LORA_PRIO_HIGH);
+
+      // Bytes per observation, header once vs header in every LR message
+      sprintf (Buffer32Bytes, "OBS LF:%d LR:%d", lw.len, lrtotal);
+      Output (Buffer32Bytes);
+    }
+    else if (binfmt) {
+      // Bytes per observation, binary vs JSON
+      sprintf (Buffer32Bytes, "OBS %s:%d JSON:%d%s", bintype, bintotal, lw.len, (keyframe) ? " K" : "");
+      Output (Buffer32Bytes);
+    }
     OBS_Clear(); 
+
+    // Link is up, send some of the backlog
+    if (transmitted && delivered) {
+      SD_N2S_Replay();
+    }
+
+    LoRaTxWait();
+    sprintf (Buffer32Bytes, "OBS AWAKE:%lums IDLE:%lums", millis() - awake, LoRaTxIdle - idle);
+    Output (Buffer32Bytes);
     
     Output("OBS_SEND:OK");
   }
@@ -158,6 +480,82 @@ void OBS_Send() {
   }
 }
 
+/*
+ * ======================================================================================================================
+ * OBS_Add() - Add value f of registry row reg at sidx, with the row's QC. Returns the value stored. See obsreg.h
+ * ======================================================================================================================
+ */
+float OBS_Add(int &sidx, int reg, float f) {
+  if ((reg < 0) || (reg >= OBSREG_COUNT)) {
+    sprintf (Buffer32Bytes, "OBS:REG %d NF", reg);
+    Output (Buffer32Bytes);
+    return (f);
+  }
+  if (sidx >= MAX_SENSORS) {
+    sprintf (Buffer32Bytes, "OBS:FULL %s", obs_registry[reg].tag);
+    Output (Buffer32Bytes);
+    return (f);
+  }
+
+  f = obsreg_qc(reg, f);
+  obs.sensor[sidx].tag = reg;
+  obs.sensor[sidx].type = obs_registry[reg].type;
+  if (obs_registry[reg].type == F_OBS) {
+    obs.sensor[sidx].f_obs = f;
+  }
+  else {
+    obs.sensor[sidx].i_obs = (int) f;
+  }
+  obs.sensor[sidx++].inuse = true;
+  return (f);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_AddInt() - Add integer i of registry row reg at sidx, no float round trip for large values
+ * ======================================================================================================================
+ */
+void OBS_AddInt(int &sidx, int reg, int i) {
+  if ((reg >= 0) && (reg < OBSREG_COUNT) && (obs_registry[reg].qc == OBSREG_QC_NONE) && (sidx < MAX_SENSORS)) {
+    obs.sensor[sidx].tag = reg;
+    obs.sensor[sidx].type = obs_registry[reg].type;
+    obs.sensor[sidx].i_obs = i;
+    obs.sensor[sidx++].inuse = true;
+  }
+  else {
+    OBS_Add(sidx, reg, (float) i);  // QC, or logs why it was not added
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Trigger() - Start the sensors that convert on their own, the DS18B20s, TSMs and TLW. They convert
+ *                 while OBS_Take() reads the other sensors and are collected at the end, the awake time is
+ *                 about the longest conversion, not the sum of them
+ * ======================================================================================================================
+ */
+void OBS_Trigger() {
+  dsmux_trigger();
+  mux_trigger();
+  if (TLW_exists) {
+    tinovi_start(TLW_ADDRESS, REG_READ_ST);
+    obs_tlw_ms = millis();
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_Timed() - Log the ms since mark for the named sensor and move mark to now
+ * ======================================================================================================================
+ */
+void OBS_Timed(const char *name, unsigned long &mark) {
+  unsigned long ms = millis();
+
+  sprintf (Buffer32Bytes, "OBS:%s %lums", name, ms - mark);
+  Output (Buffer32Bytes);
+  mark = ms;
+}
+
 /*
  * ======================================================================================================================
  * OBS_Take() - Take Observations - Should be called once a minute - fill data structure
@@ -169,12 +567,12 @@ void OBS_Take() {
   float rg2 = 0.0;
   unsigned long rg1ds;   // rain gauge delta seconds, seconds since last rain gauge observation logged
   unsigned long rg2ds;   // rain gauge delta seconds, seconds since last rain gauge observation logged
-  float ws = 0.0;
-  int wd = 0;
   float mcp3_temp = 0.0;  // globe temperature
 
   float heat_index = 0.0;
   float wetbulb_temp = 0.0;
+  unsigned long take_ms = millis();  // Acquisition start
+  unsigned long mark;                // Start of the sensor being timed
 
   rtc_timestamp(); // Set now and timestamp struture with current time
   sprintf (Buffer32Bytes, "OBS_TAKE(%s)", timestamp);
@@ -193,15 +591,12 @@ void OBS_Take() {
   // now = rtc.now(); // not needed.
   obs.ts = now.unixtime();
 
-  strcpy (obs.sensor[sidx].id, "bv");
-  obs.sensor[sidx].type = F_OBS;
-  obs.sensor[sidx].f_obs = vbat_get();
-  obs.sensor[sidx++].inuse = true;
+  mark = millis();
+  OBS_Trigger();
+  OBS_Timed("trig", mark);
 
-  strcpy (obs.sensor[sidx].id, "hth");
-  obs.sensor[sidx].type = I_OBS;
-  obs.sensor[sidx].f_obs = SystemStatusBits;
-  obs.sensor[sidx++].inuse = true;
+  OBS_Add (sidx, OBSREG_BV, vbat_get());
+  OBS_AddInt (sidx, OBSREG_HTH, SystemStatusBits);
 
   // Rain Gauge 1 - Each tip is 0.2mm of rain
   if (cf_rg1_enable) {
@@ -221,50 +616,25 @@ void OBS_Take() {
 
   // Rain Gauge 1
   if (cf_rg1_enable) {
-    strcpy (obs.sensor[sidx].id, "rg1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = rg1;
-    obs.sensor[sidx++].inuse = true;
-
+    OBS_Add (sidx, OBSREG_RG1, rg1);
     if (eeprom_exists && eeprom_valid) {
-      strcpy (obs.sensor[sidx].id, "rgt1");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = eeprom.rgt1;
-      obs.sensor[sidx++].inuse = true;
-
-      strcpy (obs.sensor[sidx].id, "rgp1");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = eeprom.rgp1;
-      obs.sensor[sidx++].inuse = true;
+      OBS_Add (sidx, OBSREG_RGT1, eeprom.rgt1);
+      OBS_Add (sidx, OBSREG_RGP1, eeprom.rgp1);
     }
   }
 
   // Rain Gauge 2
   if (cf_op1 == OP1_STATE_RAIN) {
-    strcpy (obs.sensor[sidx].id, "rg2");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = rg2;
-    obs.sensor[sidx++].inuse = true;
-
+    OBS_Add (sidx, OBSREG_RG2, rg2);
     if (eeprom_exists && eeprom_valid) {
-      strcpy (obs.sensor[sidx].id, "rgt2");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = eeprom.rgt2;
-      obs.sensor[sidx++].inuse = true;
-
-      strcpy (obs.sensor[sidx].id, "rgp2");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = eeprom.rgp2;
-      obs.sensor[sidx++].inuse = true;
+      OBS_Add (sidx, OBSREG_RGT2, eeprom.rgt2);
+      OBS_Add (sidx, OBSREG_RGP2, eeprom.rgp2);
     }
   }
 
   if (cf_op1 == OP1_STATE_RAW) {
     // OP1 Raw
-    strcpy (obs.sensor[sidx].id, "op1r");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = Pin_ReadAvg(OP1_PIN);
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_OP1R, Pin_ReadAvg(OP1_PIN));
   } 
 
   if ((cf_op1 == OP1_STATE_DIST_5M) || (cf_op1 == OP1_STATE_DIST_10M)) {
@@ -275,163 +645,72 @@ void OBS_Take() {
       ds_median = cf_ds_baseline - ds_median_raw;
     }
 
-    strcpy (obs.sensor[sidx].id, "ds");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = ds_median;
-    obs.sensor[sidx++].inuse = true;
-
-    strcpy (obs.sensor[sidx].id, "dsr");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = ds_median_raw;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_DS, ds_median);
+    OBS_Add (sidx, OBSREG_DSR, ds_median_raw);
   }
 
   if (cf_op2 == OP2_STATE_RAW) {
     // OP2 Raw
-    strcpy (obs.sensor[sidx].id, "op2r");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = Pin_ReadAvg(OP2_PIN);
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_OP2R, Pin_ReadAvg(OP2_PIN));
   }
 
   if (cf_op2 == OP2_STATE_VOLTAIC) {
     // OP2 Voltaic Battery Voltage
     float vbv = VoltaicVoltage(OP2_PIN);
-    strcpy (obs.sensor[sidx].id, "vbv");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = vbv;
-    obs.sensor[sidx++].inuse = true;
-
-    strcpy (obs.sensor[sidx].id, "vpc");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = VoltaicPercent(vbv);
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_VBV, vbv);
+    OBS_Add (sidx, OBSREG_VPC, VoltaicPercent(vbv));
   }
 
   if (cf_op3 == OP3_STATE_RAW) {
     // OP3 Raw
-    strcpy (obs.sensor[sidx].id, "op3r");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = Pin_ReadAvg(OP3_PIN);
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_OP3R, Pin_ReadAvg(OP3_PIN));
   }
 
   if (cf_op4 == OP4_STATE_RAW) {
-    // OP3 Raw
-    strcpy (obs.sensor[sidx].id, "op4r");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = Pin_ReadAvg(OP4_PIN);
-    obs.sensor[sidx++].inuse = true;
+    // OP4 Raw
+    OBS_Add (sidx, OBSREG_OP4R, Pin_ReadAvg(OP4_PIN));
   }
 
   if (!cf_nowind) {
-    // Wind Speed
-    ws = Wind_SpeedAverage();
-    ws = (isnan(ws) || (ws < QC_MIN_WS) || (ws > QC_MAX_WS)) ? QC_ERR_WS : ws;
-    strcpy (obs.sensor[sidx].id, "ws");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = ws;
-    obs.sensor[sidx++].inuse = true;
-
-    // Wind Direction
-    wd = Wind_DirectionVector();
-    wd = (isnan(wd) || (wd < QC_MIN_WD) || (wd > QC_MAX_WD)) ? QC_ERR_WD : wd;
-    strcpy (obs.sensor[sidx].id, "wd");
-    obs.sensor[sidx].type = I_OBS;
-    obs.sensor[sidx].i_obs = Wind_DirectionVector();
-    obs.sensor[sidx++].inuse = true;
-
-    // Wind Gust
-    ws = Wind_Gust();
-    ws = (isnan(ws) || (ws < QC_MIN_WS) || (ws > QC_MAX_WS)) ? QC_ERR_WS : ws;
-    strcpy (obs.sensor[sidx].id, "wg");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = ws;
-    obs.sensor[sidx++].inuse = true;
-
-    // Wind Gust Direction (Global)
-    wd = Wind_GustDirection();
-    wd = (isnan(wd) || (wd < QC_MIN_WD) || (wd > QC_MAX_WD)) ? QC_ERR_WD : wd;
-    strcpy (obs.sensor[sidx].id, "wgd");
-    obs.sensor[sidx].type = I_OBS;
-    obs.sensor[sidx].i_obs = wd;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_WS,  Wind_SpeedAverage());      // Wind Speed
+    OBS_Add (sidx, OBSREG_WD,  Wind_DirectionVector());   // Wind Direction
+    OBS_Add (sidx, OBSREG_WG,  Wind_Gust());              // Wind Gust
+    OBS_Add (sidx, OBSREG_WGD, Wind_GustDirection());     // Wind Gust Direction (Global)
   }
+  OBS_Timed("pins", mark);
  
   if (BMX_1_exists) {
     float p,t,h;
     bmx1_read(p, t, h);
     
-    // BMX1 Preasure
-    strcpy (obs.sensor[sidx].id, "bp1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = p;
-    obs.sensor[sidx++].inuse = true;
-
-    // BMX1 Temperature
-    strcpy (obs.sensor[sidx].id, "bt1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
-
-    // BMX1 Humidity
+    bmx_1_pressure = OBS_Add (sidx, OBSREG_BP1, p); // Used later for mslp calc
+    OBS_Add (sidx, OBSREG_BT1, t);
     if (BMX_1_type == BMX_TYPE_BME280) {
-      strcpy (obs.sensor[sidx].id, "bh1");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = h;
-      obs.sensor[sidx++].inuse = true;
+      OBS_Add (sidx, OBSREG_BH1, h);
     }
-
-    bmx_1_pressure = p; // Used later for mslp calc
+    OBS_Timed("bmx1", mark);
   }
   
   if (BMX_2_exists) {
     float p,t,h;
     bmx2_read(p, t, h);
 
-    // BMX2 Preasure
-    strcpy (obs.sensor[sidx].id, "bp2");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = p;
-    obs.sensor[sidx++].inuse = true;
-
-    // BMX2 Temperature
-    strcpy (obs.sensor[sidx].id, "bt2");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
-
-    // BMX2 Humidity
+    OBS_Add (sidx, OBSREG_BP2, p);
+    OBS_Add (sidx, OBSREG_BT2, t);
     if (BMX_2_type == BMX_TYPE_BME280) {
-      strcpy (obs.sensor[sidx].id, "bh2");
-      obs.sensor[sidx].type = F_OBS;
-      obs.sensor[sidx].f_obs = h;
-      obs.sensor[sidx++].inuse = true;
+      OBS_Add (sidx, OBSREG_BH2, h);
     }
+    OBS_Timed("bmx2", mark);
   }
 
   // Do Sensor observations for SHT31, SHT45, BMP581, HDC302x
   sensor_i2c_44_47_obs_do(sidx);      
+  OBS_Timed("i2c44", mark);
   
   if (HTU21DF_exists) {
-    float t = 0.0;
-    float h = 0.0;
-    
-    // HTU Humidity
-    strcpy (obs.sensor[sidx].id, "hh1");
-    obs.sensor[sidx].type = F_OBS;
-    h = htu.readHumidity();
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-    obs.sensor[sidx].f_obs = h;
-    obs.sensor[sidx++].inuse = true;
-
-    // HTU Temperature
-    strcpy (obs.sensor[sidx].id, "ht1");
-    obs.sensor[sidx].type = F_OBS;
-    t = htu.readTemperature();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_HH1, htu.readHumidity());
+    OBS_Add (sidx, OBSREG_HT1, htu.readTemperature());
+    OBS_Timed("htu", mark);
   }
 
   if (HIH8_exists) {
@@ -442,20 +721,9 @@ void OBS_Take() {
       t = -999.99;
       h = 0.0;
     }
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-
-    // HIH8 Temperature
-    strcpy (obs.sensor[sidx].id, "ht2");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
-
-    // HIH8 Humidity
-    strcpy (obs.sensor[sidx].id, "hh2");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = h;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_HT2, t);
+    OBS_Add (sidx, OBSREG_HH2, h);
+    OBS_Timed("hih8", mark);
   }
   
   if (SI1145_exists) {
@@ -486,119 +754,53 @@ void OBS_Take() {
     si_last_ir = si_ir;
     si_last_uv = si_uv;
 
-    // QC Checks
-    si_vis = (isnan(si_vis) || (si_vis < QC_MIN_VI)  || (si_vis > QC_MAX_VI)) ? QC_ERR_VI  : si_vis;
-    si_ir  = (isnan(si_ir)  || (si_ir  < QC_MIN_IR)  || (si_ir  > QC_MAX_IR)) ? QC_ERR_IR  : si_ir;
-    si_uv  = (isnan(si_uv)  || (si_uv  < QC_MIN_UV)  || (si_uv  > QC_MAX_UV)) ? QC_ERR_UV  : si_uv;
-
-    // SI Visible
-    strcpy (obs.sensor[sidx].id, "sv1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = si_vis;
-    obs.sensor[sidx++].inuse = true;
-
-    // SI IR
-    strcpy (obs.sensor[sidx].id, "si1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = si_ir;
-    obs.sensor[sidx++].inuse = true;
-
-    // SI UV
-    strcpy (obs.sensor[sidx].id, "su1");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = si_uv;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_SV1, si_vis);  // SI Visible
+    OBS_Add (sidx, OBSREG_SI1, si_ir);   // SI IR
+    OBS_Add (sidx, OBSREG_SU1, si_uv);   // SI UV
+    OBS_Timed("si", mark);
   }
     
   if (MCP_1_exists) {
-    float t = 0.0;
-   
-    // MCP1 Temperature
-    strcpy (obs.sensor[sidx].id, "mt1");
-    obs.sensor[sidx].type = F_OBS;
-    t = mcp1.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_MT1, mcp1.readTempC());  // MCP1 Temperature
+    OBS_Timed("mcp1", mark);
   }
 
   if (MCP_2_exists) {
-    float t = 0.0;
-    
-    // MCP2 Temperature
-    strcpy (obs.sensor[sidx].id, "mt2");
-    obs.sensor[sidx].type = F_OBS;
-    t = mcp2.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_MT2, mcp2.readTempC());  // MCP2 Temperature
+    OBS_Timed("mcp2", mark);
   }
 
   if (MCP_3_exists) {
-    float t = 0.0;
-
-    // MCP3 Globe Temperature
-    strcpy (obs.sensor[sidx].id, "gt1");
-    obs.sensor[sidx].type = F_OBS;
-    t = mcp3.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
-
-    mcp3_temp = t; // globe temperature
+    mcp3_temp = OBS_Add (sidx, OBSREG_GT1, mcp3.readTempC());  // MCP3 Globe Temperature
+    OBS_Timed("mcp3", mark);
   }
 
   if (MCP_4_exists) {
-    float t = 0.0;
-
-    // MCP4 Globe Temperature
-    strcpy (obs.sensor[sidx].id, "gt2");
-    obs.sensor[sidx].type = F_OBS;
-    t = mcp4.readTempC();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-    obs.sensor[sidx].f_obs = t;
-    obs.sensor[sidx++].inuse = true;
+    OBS_Add (sidx, OBSREG_GT2, mcp4.readTempC());  // MCP4 Globe Temperature
+    OBS_Timed("mcp4", mark);
   }
   
   if (PM25AQI_exists) {
-    // Atmospheric Environmental PM1.0 concentration unit µg m3
-    strcpy (obs.sensor[sidx].id, "pm1e10");
-    obs.sensor[sidx].type = I_OBS;
-    obs.sensor[sidx].i_obs = pm25aqi_obs.max_e10;
-    obs.sensor[sidx++].inuse = true;
-
-    // Atmospheric Environmental PM2.5 concentration unit µg m3
-    strcpy (obs.sensor[sidx].id, "pm1e25");
-    obs.sensor[sidx].type = I_OBS;
-    obs.sensor[sidx].i_obs = pm25aqi_obs.max_e25;
-    obs.sensor[sidx++].inuse = true;
-
-    // Atmospheric Environmental PM10.0 concentration unit µg m3
-    strcpy (obs.sensor[sidx].id, "pm1e100");
-    obs.sensor[sidx].type = I_OBS;
-    obs.sensor[sidx].i_obs = pm25aqi_obs.max_e100;
-    obs.sensor[sidx++].inuse = true;
+    // Atmospheric Environmental PM1.0, PM2.5 and PM10.0 concentration unit µg m3
+    OBS_AddInt (sidx, OBSREG_PM1E10, pm25aqi_obs.max_e10);
+    OBS_AddInt (sidx, OBSREG_PM1E25, pm25aqi_obs.max_e25);
+    OBS_AddInt (sidx, OBSREG_PM1E100, pm25aqi_obs.max_e100);
 
     // Clear readings
     pm25aqi_clear();
+    OBS_Timed("pm25", mark);
   }
   
   // Heat Index Temperature
   if (HI_exists) {
     heat_index = hi_calculate(sht1_temp, sht1_humid);
-    strcpy (obs.sensor[sidx].id, "hi");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) heat_index;
-    obs.sensor[sidx++].inuse = true;    
+    OBS_Add (sidx, OBSREG_HI, (float) heat_index);
   }
   
   // Wet Bulb Temperature
   if (WBT_exists) {
     wetbulb_temp = wbt_calculate(sht1_temp, sht1_humid);
-    strcpy (obs.sensor[sidx].id, "wbt");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) wetbulb_temp;
-    obs.sensor[sidx++].inuse = true;    
+    OBS_Add (sidx, OBSREG_WBT, (float) wetbulb_temp);
   }
 
   // Wet Bulb Globe Temperature
@@ -610,77 +812,52 @@ void OBS_Take() {
     else {
       wbgt = wbgt_using_hi(heat_index);
     }
-    strcpy (obs.sensor[sidx].id, "wbgt");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) wbgt;
-    obs.sensor[sidx++].inuse = true;    
+    OBS_Add (sidx, OBSREG_WBGT, (float) wbgt);
   }
 
   if (MSLP_exists) {
     float mslp = (float) mslp_calculate(sht1_temp, sht1_humid, bmx_1_pressure, cf_elevation);
-    strcpy (obs.sensor[sidx].id, "mslp");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) mslp;
-    obs.sensor[sidx++].inuse = true;  
+    OBS_Add (sidx, OBSREG_MSLP, (float) mslp);
   }
 
+  // Collect what OBS_Trigger() started, derived obs above are not timed
+  mark = millis();
+
   // Tinovi Leaf Wetness
   if (TLW_exists) {
-    tlw.newReading();
-    delay(100);
-    float w = tlw.getWet();
-    float t = tlw.getTemp();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-
-    strcpy (obs.sensor[sidx].id, "tlww");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) w;
-    obs.sensor[sidx++].inuse = true; 
-
-    strcpy (obs.sensor[sidx].id, "tlwt");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) t;
-    obs.sensor[sidx++].inuse = true;
+    DelaySince(obs_tlw_ms, TLW_READING_MS);
+    OBS_Add (sidx, OBSREG_TLWW, tlw.getWet());
+    OBS_Add (sidx, OBSREG_TLWT, tlw.getTemp());
+    OBS_Timed("tlw", mark);
   }
 
-  // Tinovi Soil Moisture
-  if (TSM_exists) {
-    tsm.newReading();
-    delay(100);
-    float e25 = tsm.getE25();
-    float ec = tsm.getEC();
-    float vwc = tsm.getVWC();
-    float t = tsm.getTemp();
-    t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-
-    strcpy (obs.sensor[sidx].id, "tsme25");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) e25;
-    obs.sensor[sidx++].inuse = true;
-
-    strcpy (obs.sensor[sidx].id, "tsmec");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) ec;
-    obs.sensor[sidx++].inuse = true;
-
-    strcpy (obs.sensor[sidx].id, "tsmvwc");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) vwc;
-    obs.sensor[sidx++].inuse = true; 
-
-    strcpy (obs.sensor[sidx].id, "tsmt");
-    obs.sensor[sidx].type = F_OBS;
-    obs.sensor[sidx].f_obs = (float) t;
-    obs.sensor[sidx++].inuse = true;
+  // Tinovi Soil Moisture, on the mux or main bus
+  if (MUX_exists || TSM_exists) {
+    mux_obs_do(sidx);
+    OBS_Timed("tsm", mark);
   }
 
-  // Tinovi Soil Moisture
-  mux_obs_do(sidx);
-
   // Dallas Sensors Temperature on mux
-  dsmux_obs_do(sidx);
+  if (DSMUX_exists) {
+    dsmux_obs_do(sidx);
+    OBS_Timed("dsmux", mark);
+  }
   
-  Output("OBS_TAKE(DONE)");
+  sprintf (Buffer32Bytes, "OBS_TAKE(DONE) %lums", millis() - take_ms);
+  Output (Buffer32Bytes);
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SendNow() - Send the observation, then what was held back behind it
+ * ======================================================================================================================
+ */
+void OBS_SendNow() {
+  LoRaObsWaiting = false;  // Before the send, N2S replay goes out behind it
+  OBS_Send();           // From obs structure build JSON and send
+  obs_sendtime = 0;
+  LoRaTxQueueFlush();   // Deferred messages, highest class first
+  LoRaRelayForward();   // Neighbor frames heard go after our own
 }
 
 /*
@@ -693,6 +870,65 @@ void OBS_Do() {
   
   Do_WRDA_Samples();    // Do Wind, Distance and Air Quality 1 minute of 1 second samples
   
+  if (obs_sendtime) {
+    OBS_SendNow();      // Last one still waiting for its slot, should not happen
+  }
+
   OBS_Take();          // Take an observation
-  OBS_Send();          // From obs structure build JSON and send
+
+  if (cf_lora_slots && obs.inuse) {
+    // Send in our slot of the period the observation belongs to. Wind, distance and air samples start
+    // a minute early, so OBS_Take() can finish a second or so before the boundary it was taken for
+    uint32_t period = cf_obs_period * 60;
+    uint32_t boundary = obs.ts + OBS_SLOT_EARLY;
+
+    boundary -= boundary % period;
+    obs_sendtime = boundary + ((cf_lora_unitid % cf_lora_slots) * cf_lora_slotwidth);
+    if (obs_sendtime <= obs.ts) {
+      obs_sendtime = 0;  // Slot 0 or we are already past it
+    }
+  }
+
+  if (cf_lora_relay) {
+    // Relay, listen for neighbors in the earlier slots, stop at our own
+    unsigned long listen = cf_lora_relay;
+    if (obs_sendtime) {
+      uint32_t t = rtc.now().unixtime();
+      listen = (t >= obs_sendtime) ? 0 : min(listen, (unsigned long) (obs_sendtime - t));
+    }
+    LoRaRelayListen(listen * 1000);
+  }
+
+  if (obs_sendtime) {
+    LoRaObsWaiting = true;  // Lower classes wait for it
+    sprintf (Buffer32Bytes, "OBS SLOT +%lus", obs_sendtime - obs.ts);
+    Output (Buffer32Bytes);
+  }
+  else {
+    OBS_SendNow();
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SecondsToSend() - Seconds until the slotted send is due, -1 if nothing pending
+ * ======================================================================================================================
+ */
+int OBS_SecondsToSend() {
+  if (!obs_sendtime) {
+    return (-1);
+  }
+  uint32_t t = rtc.now().unixtime();
+  return ((t >= obs_sendtime) ? 0 : (obs_sendtime - t));
+}
+
+/*
+ * ======================================================================================================================
+ * OBS_SendPending() - Send the observation if its slot has come
+ * ======================================================================================================================
+ */
+void OBS_SendPending() {
+  if (OBS_SecondsToSend() == 0) {
+    OBS_SendNow();
+  }
 }
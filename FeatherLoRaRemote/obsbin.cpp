@@ -0,0 +1,86 @@
+/*
+ * ======================================================================================================================
+ *  obsbin.cpp - Binary Observation Frame Functions
+ * ======================================================================================================================
+ */
+#include <Arduino.h>
+
+#include "include/feather.h"
+#include "include/main.h"
+#include "include/obsreg.h"
+#include "include/obsbin.h"
+
+/*
+ * ======================================================================================================================
+ * Fuction Definations
+ * =======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ * obsbin_put_varint() - Zig-zag varint encode value into buf, return bytes used (1-5)
+ * ======================================================================================================================
+ */
+int obsbin_put_varint(byte *buf, int32_t value) {
+  uint32_t zz = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+  int n = 0;
+
+  while (zz >= 0x80) {
+    buf[n++] = (zz & 0x7F) | 0x80;
+    zz >>= 7;
+  }
+  buf[n++] = zz;
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * obsbin_header() - Put version, epoch and device id into buf, return bytes used
+ * ======================================================================================================================
+ */
+int obsbin_header(byte *buf, uint32_t epoch) {
+  int n = 0;
+
+  buf[n++] = OBSBIN_VERSION;
+  buf[n++] = epoch & 0xFF;
+  buf[n++] = (epoch >> 8) & 0xFF;
+  buf[n++] = (epoch >> 16) & 0xFF;
+  buf[n++] = (epoch >> 24) & 0xFF;
+
+  // DeviceID is 16 hex characters, pack it back to 8 bytes
+  for (int i=0; i<16; i+=2) {
+    char hex[3] = { DeviceID[i], DeviceID[i+1], 0 };
+    buf[n++] = (byte) strtoul(hex, NULL, 16);
+  }
+  return (n);
+}
+
+/*
+ * ======================================================================================================================
+ * obsbin_scale() - Return value scaled by 10^decimals of the tag
+ * ======================================================================================================================
+ */
+int32_t obsbin_scale(uint8_t tidx, float f, int32_t i, bool is_float) {
+  double scale = 1.0;
+
+  for (int d=0; d<obs_registry[tidx].decimals; d++) {
+    scale *= 10.0;
+  }
+
+  if (is_float) {
+    return ((int32_t) lround((double) f * scale));
+  }
+  else {
+    return ((int32_t) (i * scale));
+  }
+}
+
+/*
+ * ======================================================================================================================
+ * obsbin_record() - Put sensor record into buf, return bytes used. buf needs room for 6 bytes.
+ * ======================================================================================================================
+ */
+int obsbin_record(byte *buf, uint8_t tidx, float f, int32_t i, bool is_float) {
+  buf[0] = tidx;
+  return (1 + obsbin_put_varint(buf+1, obsbin_scale(tidx, f, i, is_float)));
+}
@@ -0,0 +1,116 @@
+/*
+ * ======================================================================================================================
+ *  obsreg.cpp - Sensor Registry Functions
+ * ======================================================================================================================
+ */
+#include <Arduino.h>
+
+#include "include/qc.h"
+#include "include/obs.h"
+#include "include/obsreg.h"
+
+/*
+ * ======================================================================================================================
+ * Variables and Data Structures
+ * =======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ *  Sensor Registry - See obsreg.h. Index in this table is what is sent over the air. Only append to the end.
+ *    Floats (F_OBS) are reported with 1 decimal in the JSON, so they are scaled by 10.
+ * ======================================================================================================================
+ */
+const OBSREG obs_registry[] = {
+  {"bv",       F_OBS, 1, OBSREG_QC_NONE }, {"hth",      I_OBS, 0, OBSREG_QC_NONE }, {"rg1",      F_OBS, 1, OBSREG_QC_NONE }, //   0 -   2
+  {"rgt1",     F_OBS, 1, OBSREG_QC_NONE }, {"rgp1",     F_OBS, 1, OBSREG_QC_NONE }, {"rg2",      F_OBS, 1, OBSREG_QC_NONE }, //   3 -   5
+  {"rgt2",     F_OBS, 1, OBSREG_QC_NONE }, {"rgp2",     F_OBS, 1, OBSREG_QC_NONE }, {"op1r",     F_OBS, 1, OBSREG_QC_NONE }, //   6 -   8
+  {"ds",       F_OBS, 1, OBSREG_QC_NONE }, {"dsr",      F_OBS, 1, OBSREG_QC_NONE }, {"op2r",     F_OBS, 1, OBSREG_QC_NONE }, //   9 -  11
+  {"vbv",      F_OBS, 1, OBSREG_QC_NONE }, {"vpc",      F_OBS, 1, OBSREG_QC_NONE }, {"op3r",     F_OBS, 1, OBSREG_QC_NONE }, //  12 -  14
+  {"op4r",     F_OBS, 1, OBSREG_QC_NONE }, {"ws",       F_OBS, 1, OBSREG_QC_WS   }, {"wd",       I_OBS, 0, OBSREG_QC_WD   }, //  15 -  17
+  {"wg",       F_OBS, 1, OBSREG_QC_WS   }, {"wgd",      I_OBS, 0, OBSREG_QC_WD   }, {"bp1",      F_OBS, 1, OBSREG_QC_P    }, //  18 -  20
+  {"bt1",      F_OBS, 1, OBSREG_QC_T    }, {"bh1",      F_OBS, 1, OBSREG_QC_RH   }, {"bp2",      F_OBS, 1, OBSREG_QC_P    }, //  21 -  23
+  {"bt2",      F_OBS, 1, OBSREG_QC_T    }, {"bh2",      F_OBS, 1, OBSREG_QC_RH   }, {"bp3",      F_OBS, 1, OBSREG_QC_P    }, //  24 -  26
+  {"bt3",      F_OBS, 1, OBSREG_QC_T    }, {"bp4",      F_OBS, 1, OBSREG_QC_P    }, {"bt4",      F_OBS, 1, OBSREG_QC_T    }, //  27 -  29
+  {"st1",      F_OBS, 1, OBSREG_QC_T    }, {"sh1",      F_OBS, 1, OBSREG_QC_RH   }, {"st2",      F_OBS, 1, OBSREG_QC_T    }, //  30 -  32
+  {"sh2",      F_OBS, 1, OBSREG_QC_RH   }, {"hdt1",     F_OBS, 1, OBSREG_QC_T    }, {"hdh1",     F_OBS, 1, OBSREG_QC_RH   }, //  33 -  35
+  {"hdt2",     F_OBS, 1, OBSREG_QC_T    }, {"hdh2",     F_OBS, 1, OBSREG_QC_RH   }, {"hdt3",     F_OBS, 1, OBSREG_QC_T    }, //  36 -  38
+  {"hdh3",     F_OBS, 1, OBSREG_QC_RH   }, {"hdt4",     F_OBS, 1, OBSREG_QC_T    }, {"hdh4",     F_OBS, 1, OBSREG_QC_RH   }, //  39 -  41
+  {"hh1",      F_OBS, 1, OBSREG_QC_RH   }, {"ht1",      F_OBS, 1, OBSREG_QC_T    }, {"ht2",      F_OBS, 1, OBSREG_QC_T    }, //  42 -  44
+  {"hh2",      F_OBS, 1, OBSREG_QC_RH   }, {"sv1",      F_OBS, 1, OBSREG_QC_VI   }, {"si1",      F_OBS, 1, OBSREG_QC_IR   }, //  45 -  47
+  {"su1",      F_OBS, 1, OBSREG_QC_UV   }, {"mt1",      F_OBS, 1, OBSREG_QC_T    }, {"mt2",      F_OBS, 1, OBSREG_QC_T    }, //  48 -  50
+  {"gt1",      F_OBS, 1, OBSREG_QC_T    }, {"gt2",      F_OBS, 1, OBSREG_QC_T    }, {"pm1e10",   I_OBS, 0, OBSREG_QC_NONE }, //  51 -  53
+  {"pm1e25",   I_OBS, 0, OBSREG_QC_NONE }, {"pm1e100",  I_OBS, 0, OBSREG_QC_NONE }, {"hi",       F_OBS, 1, OBSREG_QC_NONE }, //  54 -  56
+  {"wbt",      F_OBS, 1, OBSREG_QC_NONE }, {"wbgt",     F_OBS, 1, OBSREG_QC_NONE }, {"mslp",     F_OBS, 1, OBSREG_QC_NONE }, //  57 -  59
+  {"tlww",     F_OBS, 1, OBSREG_QC_NONE }, {"tlwt",     F_OBS, 1, OBSREG_QC_T    }, {"tsme25",   F_OBS, 1, OBSREG_QC_NONE }, //  60 -  62
+  {"tsmec",    F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc",   F_OBS, 1, OBSREG_QC_NONE }, {"tsmt",     F_OBS, 1, OBSREG_QC_T    }, //  63 -  65
+  {"dst0",     F_OBS, 1, OBSREG_QC_T    }, {"dst1",     F_OBS, 1, OBSREG_QC_T    }, {"dst2",     F_OBS, 1, OBSREG_QC_T    }, //  66 -  68
+  {"dst3",     F_OBS, 1, OBSREG_QC_T    }, {"dst4",     F_OBS, 1, OBSREG_QC_T    }, {"dst5",     F_OBS, 1, OBSREG_QC_T    }, //  69 -  71
+  {"dst6",     F_OBS, 1, OBSREG_QC_T    }, {"dst7",     F_OBS, 1, OBSREG_QC_T    }, {"tsme25-1", F_OBS, 1, OBSREG_QC_NONE }, //  72 -  74
+  {"tsmec-1",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-1", F_OBS, 1, OBSREG_QC_NONE }, {"tsmt-1",   F_OBS, 1, OBSREG_QC_T    }, //  75 -  77
+  {"tsme25-2", F_OBS, 1, OBSREG_QC_NONE }, {"tsmec-2",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-2", F_OBS, 1, OBSREG_QC_NONE }, //  78 -  80
+  {"tsmt-2",   F_OBS, 1, OBSREG_QC_T    }, {"tsme25-3", F_OBS, 1, OBSREG_QC_NONE }, {"tsmec-3",  F_OBS, 1, OBSREG_QC_NONE }, //  81 -  83
+  {"tsmvwc-3", F_OBS, 1, OBSREG_QC_NONE }, {"tsmt-3",   F_OBS, 1, OBSREG_QC_T    }, {"tsme25-4", F_OBS, 1, OBSREG_QC_NONE }, //  84 -  86
+  {"tsmec-4",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-4", F_OBS, 1, OBSREG_QC_NONE }, {"tsmt-4",   F_OBS, 1, OBSREG_QC_T    }, //  87 -  89
+  {"tsme25-5", F_OBS, 1, OBSREG_QC_NONE }, {"tsmec-5",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-5", F_OBS, 1, OBSREG_QC_NONE }, //  90 -  92
+  {"tsmt-5",   F_OBS, 1, OBSREG_QC_T    }, {"tsme25-6", F_OBS, 1, OBSREG_QC_NONE }, {"tsmec-6",  F_OBS, 1, OBSREG_QC_NONE }, //  93 -  95
+  {"tsmvwc-6", F_OBS, 1, OBSREG_QC_NONE }, {"tsmt-6",   F_OBS, 1, OBSREG_QC_T    }, {"tsme25-7", F_OBS, 1, OBSREG_QC_NONE }, //  96 -  98
+  {"tsmec-7",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-7", F_OBS, 1, OBSREG_QC_NONE }, {"tsmt-7",   F_OBS, 1, OBSREG_QC_T    }, //  99 - 101
+  {"tsme25-8", F_OBS, 1, OBSREG_QC_NONE }, {"tsmec-8",  F_OBS, 1, OBSREG_QC_NONE }, {"tsmvwc-8", F_OBS, 1, OBSREG_QC_NONE }, // 102 - 104
+  {"tsmt-8",   F_OBS, 1, OBSREG_QC_T    }, {"st3",      F_OBS, 1, OBSREG_QC_T    }, {"sh3",      F_OBS, 1, OBSREG_QC_RH   }, // 105 - 107
+  {"st4",      F_OBS, 1, OBSREG_QC_T    }, {"sh4",      F_OBS, 1, OBSREG_QC_RH   }, {"bt5",      F_OBS, 1, OBSREG_QC_T    }, // 108 - 110
+  {"bp5",      F_OBS, 1, OBSREG_QC_P    }, {"bt6",      F_OBS, 1, OBSREG_QC_T    }, {"bp6",      F_OBS, 1, OBSREG_QC_P    }, // 111 - 113
+};
+static_assert(sizeof(obs_registry) / sizeof(obs_registry[0]) == OBSREG_COUNT, "obs_registry[] and OBSREG_ID differ");
+
+/*
+ * ======================================================================================================================
+ *  QC Ranges - Indexed by OBSREG_QC_TYPE, See qc.h
+ * ======================================================================================================================
+ */
+const OBSREG_QC obsreg_qc_range[] = {
+  {0.0,       0.0,       0.0},        // OBSREG_QC_NONE, not used
+  {QC_MIN_T,  QC_MAX_T,  QC_ERR_T},
+  {QC_MIN_RH, QC_MAX_RH, QC_ERR_RH},
+  {QC_MIN_P,  QC_MAX_P,  QC_ERR_P},
+  {QC_MIN_VI, QC_MAX_VI, QC_ERR_VI},
+  {QC_MIN_IR, QC_MAX_IR, QC_ERR_IR},
+  {QC_MIN_UV, QC_MAX_UV, QC_ERR_UV},
+  {QC_MIN_WS, QC_MAX_WS, QC_ERR_WS},
+  {QC_MIN_WD, QC_MAX_WD, QC_ERR_WD},
+};
+
+/*
+ * ======================================================================================================================
+ * Fuction Definations
+ * =======================================================================================================================
+ */
+
+/*
+ * ======================================================================================================================
+ * obsreg_index() - Return index of tag in obs_registry[] or OBSREG_UNKN. For setup, not each observation
+ * ======================================================================================================================
+ */
+uint8_t obsreg_index(const char *tag) {
+  for (int r=0; r<OBSREG_COUNT; r++) {
+    if (strcmp(obs_registry[r].tag, tag) == 0) {
+      return (r);
+    }
+  }
+  return (OBSREG_UNKN);
+}
+
+/*
+ * ======================================================================================================================
+ * obsreg_qc() - Return v, or the error value of the row's QC range if v is NaN or outside it
+ * ======================================================================================================================
+ */
+float obsreg_qc(uint8_t reg, float v) {
+  const OBSREG_QC *q;
+
+  if (obs_registry[reg].qc == OBSREG_QC_NONE) {
+    return (v);
+  }
+  q = &obsreg_qc_range[obs_registry[reg].qc];
+  return ((isnan(v) || (v < q->min) || (v > q->max)) ? q->err : v);
+}
@@ -7,8 +7,10 @@
 #include "include/mux.h"
 #include "include/eeprom.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/lora.h"
 #include "include/time.h"
+#include "include/cf.h"
 #include "include/sdcard.h"
 
 /*
@@ -20,6 +22,7 @@ File SD_fp;
 char SD_obsdir[] = "/OBS";  // Store our obs in this directory. At Power on, it is created if does not exist
 bool SD_exists = false;     // Set to true if SD card found at boot
 char SD_crt_file[] = "CRT.TXT";             // if file exists clear rain totals and delete file
+char SD_n2s_file[] = "N2S.DAT";             // Need to Send queue, See sdcard.h
 
 /*
  * ======================================================================================================================
@@ -124,3 +127,120 @@ void SD_ClearRainTotals() {
     Output ("CRT:ERR-CLK");
   }
 }
+
+/* 
+ *=======================================================================================================================
+ * SD_N2S_Check() - At boot, set SSB_N2S if there are messages left to send
+ *=======================================================================================================================
+ */
+void SD_N2S_Check() {
+  if (SD_exists && SD.exists(SD_n2s_file)) {
+    LoRaDisableSPI(); // Disable LoRA SPI0 Chip Select
+
+    File fp = SD.open(SD_n2s_file, FILE_READ);
+    if (fp) {
+      unsigned long size = fp.size();
+      fp.close();
+
+      if (eeprom.n2sfp > size) {
+        eeprom.n2sfp = 0; // Safty Check, file is not the one n2sfp was for
+      }
+      if (eeprom.n2sfp < size) {
+        SystemStatusBits |= SSB_N2S;  // Turn On Bit
+      }
+      sprintf (Buffer32Bytes, "N2S:%lu/%lu", eeprom.n2sfp, size);
+      Output (Buffer32Bytes);
+    }
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * SD_N2S_Append() - Add message to the end of the Need to Send queue
+ *=======================================================================================================================
+ */
+void SD_N2S_Append(const char *mtype, const byte *msg, int len) {
+  if (!SD_exists || !cf_n2s_rate || (len <= 0) || (len > 255)) {
+    return;
+  }
+
+  LoRaDisableSPI(); // Disable LoRA SPI0 Chip Select
+
+  File fp = SD.open(SD_n2s_file, FILE_WRITE);
+  if (fp) {
+    if (fp.size() < SD_N2S_MAX_SIZE) {
+      fp.write((byte) len);
+      fp.write((const byte *) mtype, 2);
+      fp.write(msg, len);
+      SystemStatusBits |= SSB_N2S;  // Turn On Bit
+      Output ("N2S:ADD");
+    }
+    else {
+      Output ("N2S:FULL");
+    }
+    fp.close();
+  }
+  else {
+    Output ("N2S:OPEN ERR");
+  }
+}
+
+/* 
+ *=======================================================================================================================
+ * SD_N2S_Replay() - Send up to n2s_rate queued messages, oldest first. Stop at the first not sent.
+ *=======================================================================================================================
+ */
+void SD_N2S_Replay() {
+  byte msg[256];
+  char mtype[3];
+  int len;
+  int sent = 0;
+
+  if (!SD_exists || !cf_n2s_rate || !(SystemStatusBits & SSB_N2S)) {
+    return;
+  }
+
+  while (sent < cf_n2s_rate) {
+    LoRaDisableSPI(); // Disable LoRA SPI0 Chip Select
+
+    File fp = SD.open(SD_n2s_file, FILE_READ);
+    if (!fp) {
+      Output ("N2S:OPEN ERR");
+      return;
+    }
+
+    // Queue empty, start a new file
+    if (eeprom.n2sfp >= fp.size()) {
+      fp.close();
+      SD.remove(SD_n2s_file);
+      eeprom.n2sfp = 0;
+      EEPROM_UpdateN2S();
+      SystemStatusBits &= ~SSB_N2S;  // Turn Off Bit
+      Output ("N2S:EMPTY");
+      return;
+    }
+
+    fp.seek(eeprom.n2sfp);
+    len = fp.read();
+    memset(mtype, 0, sizeof(mtype));
+    if ((len <= 0) || (fp.read((byte *) mtype, 2) != 2) || (fp.read(msg, len) != len)) {
+      // Short record, skip the rest of the file
+      eeprom.n2sfp = fp.size();
+      fp.close();
+      EEPROM_UpdateN2S();
+      Output ("N2S:READ ERR");
+      continue;
+    }
+    fp.close();
+
+    // SD is done with the SPI bus, now the radio can have it
+    if (!SendLoRaN2S(msg, len, mtype)) {
+      Output ("N2S:NOT SENT");
+      return;
+    }
+
+    eeprom.n2sfp += 3 + len;
+    EEPROM_UpdateN2S();
+    sent++;
+  }
+}
@@ -1084,6 +1084,18 @@ void tsm_initialize() {
   Output (msgp);
 }
 
+/* 
+ *=======================================================================================================================
+ * tinovi_start() - Start a Tinovi reading, reg is the read start register. The libraries' newReading() would then
+ *                  delay() the whole conversion, the caller waits TLW_READING_MS / TSM_READING_MS once instead
+ *=======================================================================================================================
+ */
+void tinovi_start(uint8_t address, uint8_t reg) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.endTransmission();
+}
+
 /* 
  *=======================================================================================================================
  * mslp_initialize() - mean sea level pressure init MSLP_exists if all the input exist.
@@ -8,7 +8,9 @@
 #include "include/sensors_i2c_44_47.h"
 #include "include/support.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/obs.h"
+#include "include/obsreg.h"
 #include "include/main.h"
 
 /*
@@ -18,6 +20,9 @@
  */
 I2C_44_47_SENSOR_SLOT i2c_44_47_sensors[I2C_44_47_SENSOR_COUNT];
 
+// Obs tag prefixes by I2C_44_47_SENSOR_TYPE, the slot id is appended
+const char *i2c_44_47_tag_prefix[][2] = {{"", ""}, {"st", "sh"}, {"st", "sh"}, {"bt", "bp"}, {"hdt", "hdh"}};
+
 bool SHT_1_exists = false;
 float sht1_humid = 0.0;
 float sht1_temp = 0.0;
@@ -337,6 +342,7 @@ void sensor_i2c_44_47_info(char *rest, int size, const char *&comma) {
 void sensor_i2c_44_47_statmon(int idx, char *buf) {
   float t,p,h;
   double dt,dh;
+  char f1[MSGW_FMT_LEN], f2[MSGW_FMT_LEN];
 
   if ((idx <0) || (idx>=I2C_44_47_SENSOR_COUNT)) {
     sprintf (buf, "INVAL IDX %d", idx);
@@ -352,7 +358,7 @@ void sensor_i2c_44_47_statmon(int idx, char *buf) {
       h = sht3.readHumidity();
       t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
       h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-      sprintf (buf, "SHT31-%d T%.2f H%.2f", id, t, h);
+      sprintf (buf, "SHT31-%d T%s H%s", id, MSGW_Fmt(f1, t, 2), MSGW_Fmt(f2, h, 2));
       break;
     }
     case SENSOR_SHT45: {
@@ -363,7 +369,7 @@ void sensor_i2c_44_47_statmon(int idx, char *buf) {
       h = humidity.relative_humidity;
       t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
       h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-      sprintf (buf, "SHT45-%d T%.2f H%.2f", id, t, h);
+      sprintf (buf, "SHT45-%d T%s H%s", id, MSGW_Fmt(f1, t, 2), MSGW_Fmt(f2, h, 2));
       break;
     }
     case SENSOR_BMP581:{
@@ -372,7 +378,7 @@ void sensor_i2c_44_47_statmon(int idx, char *buf) {
       p = bmp5.readPressure();
       t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
       p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-      sprintf (buf, "BMP5-%d T%.2f P%.2f", id, t, p);
+      sprintf (buf, "BMP5-%d T%s P%s", id, MSGW_Fmt(f1, t, 2), MSGW_Fmt(f2, p, 2));
       break;
     }
     case SENSOR_HDC302X: {
@@ -380,7 +386,7 @@ void sensor_i2c_44_47_statmon(int idx, char *buf) {
       if (hdc.readTemperatureHumidityOnDemand(dt, dh, TRIGGERMODE_LP0)) {
         t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
         h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-        sprintf (buf, "HDC-%d T%.2f H%.2f", id, dt, dh);
+        sprintf (buf, "HDC-%d T%s H%s", id, MSGW_Fmt(f1, dt, 2), MSGW_Fmt(f2, dh, 2));
       }
       else {
         sprintf (buf, "HDC-%d READ ERR", id);
@@ -409,29 +415,11 @@ void sensor_i2c_44_47_obs_do(int &sidx) {
 
       case SENSOR_SHT31 : {
         Adafruit_SHT31 &sht3 = i2c_44_47_sensors[idx].sht3; // Create a Alias
-        int id = i2c_44_47_sensors[idx].id;
-        float t = 0.0;
-        float h = 0.0;
-
-        // SHT3 Temperature
-        sprintf (Buffer32Bytes, "st%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        t = sht3.readTemperature();
-        t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-        obs.sensor[sidx].f_obs = t;
-        obs.sensor[sidx++].inuse = true;
-    
-        // SHT3 Humidity   
-        sprintf (Buffer32Bytes, "sh%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        h = sht3.readHumidity();
-        h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-        obs.sensor[sidx].f_obs = h;
-        obs.sensor[sidx++].inuse = true;
+        uint8_t *tag = i2c_44_47_sensors[idx].tag;
+        float t = OBS_Add (sidx, tag[0], sht3.readTemperature());  // SHT3 Temperature
+        float h = OBS_Add (sidx, tag[1], sht3.readHumidity());     // SHT3 Humidity
 
-        if (id == 1) {
+        if (i2c_44_47_sensors[idx].id == 1) {
           // save for derived observations
           sht1_temp = t;
           sht1_humid = h; 
@@ -442,32 +430,14 @@ void sensor_i2c_44_47_obs_do(int &sidx) {
 
       case SENSOR_SHT45 : {
         Adafruit_SHT4x &sht4 = i2c_44_47_sensors[idx].sht4;  // Create a Alias
-        int id = i2c_44_47_sensors[idx].id;
+        uint8_t *tag = i2c_44_47_sensors[idx].tag;
         sensors_event_t humidity, temp;
-        float t=0.0;
-        float h=0.0;
 
         sht4.getEvent(&humidity, &temp);// populate temp and humidity objects with fresh data
-        t = temp.temperature;
-        h = humidity.relative_humidity;
-        t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-        h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
+        float t = OBS_Add (sidx, tag[0], temp.temperature);             // SHT4 Temperature
+        float h = OBS_Add (sidx, tag[1], humidity.relative_humidity);   // SHT4 Humidity
 
-        // SHT4 Temperature
-        sprintf (Buffer32Bytes, "st%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = t;
-        obs.sensor[sidx++].inuse = true;
-    
-        // SHT4 Humidity   
-        sprintf (Buffer32Bytes, "sh%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = h;
-        obs.sensor[sidx++].inuse = true;
-
-        if (id == 1) {
+        if (i2c_44_47_sensors[idx].id == 1) {
           // save for derived observations
           sht1_temp = t;
           sht1_humid = h;
@@ -478,30 +448,12 @@ void sensor_i2c_44_47_obs_do(int &sidx) {
 
       case SENSOR_BMP581 : {
         Adafruit_BMP5xx &bmp5 = i2c_44_47_sensors[idx].bmp5;
-        int id = i2c_44_47_sensors[idx].id;
-        float t=0.0;
-        float p=0.0;
+        uint8_t *tag = i2c_44_47_sensors[idx].tag;
 
-        t = bmp5.readTemperature();
-        p = bmp5.readPressure();
-        t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-        p = (isnan(p) || (p < QC_MIN_P)  || (p > QC_MAX_P))  ? QC_ERR_P  : p;
-
-        // BMP Temperature
-        sprintf (Buffer32Bytes, "bt%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = (float) t;
-        obs.sensor[sidx++].inuse = true;
-
-        // BMP Pressure 
-        sprintf (Buffer32Bytes, "bp%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = (float) p;
-        obs.sensor[sidx++].inuse = true;
+        OBS_Add (sidx, tag[0], bmp5.readTemperature());        // BMP Temperature
+        float p = OBS_Add (sidx, tag[1], bmp5.readPressure());  // BMP Pressure 
         
-        if (id == 1) {
+        if (i2c_44_47_sensors[idx].id == 1) {
           bmx_1_pressure = p; // Used later for mslp calc
         }
 
@@ -510,32 +462,17 @@ void sensor_i2c_44_47_obs_do(int &sidx) {
 
       case SENSOR_HDC302X : {
         Adafruit_HDC302x &hdc = i2c_44_47_sensors[idx].hdc; // Create a Alias
-        int id = i2c_44_47_sensors[idx].id;
+        uint8_t *tag = i2c_44_47_sensors[idx].tag;
         double t = -999.9;
         double h = -999.9;
 
-        if (hdc.readTemperatureHumidityOnDemand(t, h, TRIGGERMODE_LP0)) {
-          t = (isnan(t) || (t < QC_MIN_T)  || (t > QC_MAX_T))  ? QC_ERR_T  : t;
-          h = (isnan(h) || (h < QC_MIN_RH) || (h > QC_MAX_RH)) ? QC_ERR_RH : h;
-        }
-        else {
-          sprintf (Buffer32Bytes, "HDC%d READ ERR", id);
+        if (!hdc.readTemperatureHumidityOnDemand(t, h, TRIGGERMODE_LP0)) {
+          sprintf (Buffer32Bytes, "HDC%d READ ERR", i2c_44_47_sensors[idx].id);
           Output (Buffer32Bytes);
         }
 
-        // HDC1 Temperature
-        sprintf (Buffer32Bytes, "hdt%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = (float) t;
-        obs.sensor[sidx++].inuse = true;
-
-        // HDC1 Humidity
-        sprintf (Buffer32Bytes, "hdh%d", id);
-        strcpy (obs.sensor[sidx].id, Buffer32Bytes);
-        obs.sensor[sidx].type = F_OBS;
-        obs.sensor[sidx].f_obs = (float) h;
-        obs.sensor[sidx++].inuse = true;
+        OBS_Add (sidx, tag[0], (float) t);  // HDC Temperature
+        OBS_Add (sidx, tag[1], (float) h);  // HDC Humidity
 
         break;
       }
@@ -669,5 +606,17 @@ void sensor_initialize_i2c_44_47() {
         break;
       }
     }
+
+    // Look up the registry rows once. A tag with no row would not be in LB, LD or LM messages, say so now
+    for (int k=0; k<2; k++) {
+      char tag[8];
+
+      snprintf (tag, sizeof(tag), "%s%d", i2c_44_47_tag_prefix[i2c_44_47_sensors[idx].type][k], i2c_44_47_sensors[idx].id);
+      i2c_44_47_sensors[idx].tag[k] = obsreg_index(tag);
+      if (i2c_44_47_sensors[idx].id && (i2c_44_47_sensors[idx].tag[k] == OBSREG_UNKN)) {
+        sprintf (Buffer32Bytes, " OBS:TAG %s NF", tag);
+        Output (Buffer32Bytes);
+      }
+    }
   }
 }
\ No newline at end of file
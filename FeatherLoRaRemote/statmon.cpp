@@ -11,6 +11,7 @@
 #include "include/wrda.h"
 #include "include/cf.h"
 #include "include/output.h"
+#include "include/msgw.h"
 #include "include/support.h"
 #include "include/time.h"
 #include "include/main.h"
@@ -40,6 +41,7 @@ void StationMonitor() {
   static int b = 0;
   static int p = 0;  // use to loop through each probe 0,1,2
   int r, c, len;
+  char f1[MSGW_FMT_LEN], f2[MSGW_FMT_LEN], f3[MSGW_FMT_LEN];  // MSGW_Fmt() values
   
   OLED_ClearDisplayBuffer();
   
@@ -94,7 +96,7 @@ void StationMonitor() {
     if (BMX_1_exists) {
       float p,t,h;
       bmx1_read(p, t, h);
-      sprintf (msgbuf, "B1 %.2f %.2f %.2f", p,t,h);
+      sprintf (msgbuf, "B1 %s %s %s", MSGW_Fmt(f1, p, 2), MSGW_Fmt(f2, t, 2), MSGW_Fmt(f3, h, 2));
     }
     else {
       sprintf (msgbuf, "B1 NF");
@@ -105,7 +107,7 @@ void StationMonitor() {
     if (BMX_2_exists) {
       float p,t,h;
       bmx2_read(p, t, h);
-      sprintf (msgbuf, "B2 %.2f %.2f %.2f", p,t,h);
+      sprintf (msgbuf, "B2 %s %s %s", MSGW_Fmt(f1, p, 2), MSGW_Fmt(f2, t, 2), MSGW_Fmt(f3, h, 2));
     }
     else {
       sprintf (msgbuf, "B2 NF");
@@ -117,7 +119,7 @@ void StationMonitor() {
       
     if (MCP_1_exists) {
       float mcp_temp = mcp1.readTempC();   
-      sprintf (msgbuf, "MCP1 T%.2f", mcp_temp);
+      sprintf (msgbuf, "MCP1 T%s", MSGW_Fmt(f1, mcp_temp, 2));
     }
     else {
       sprintf (msgbuf, "MCP1 NF");
@@ -127,7 +129,7 @@ void StationMonitor() {
   if (cycle == 3) {
     if (MCP_2_exists) {
       float mcp_temp = mcp2.readTempC();   
-      sprintf (msgbuf, "MCP2 T%.2f", mcp_temp);
+      sprintf (msgbuf, "MCP2 T%s", MSGW_Fmt(f1, mcp_temp, 2));
     }
     else {
       sprintf (msgbuf, "MCP2 NF");
@@ -151,8 +153,8 @@ void StationMonitor() {
    sprintf (msgbuf, "%s", Buffer32Bytes);
   }
   if (cycle == 8) {
-    sprintf (msgbuf, "BATT:%.2f HTH:%04X", 
-    batt, SystemStatusBits); 
+    sprintf (msgbuf, "BATT:%s HTH:%04X", 
+    MSGW_Fmt(f1, batt, 2), SystemStatusBits); 
   }
 
   if (cycle == 9) {   
@@ -160,7 +162,7 @@ void StationMonitor() {
       float htu_humid = htu.readHumidity();
       float htu_temp = htu.readTemperature();
 
-      sprintf (msgbuf, "HTU H:%.2f T:%.2f", htu_humid, htu_temp);
+      sprintf (msgbuf, "HTU H:%s T:%s", MSGW_Fmt(f1, htu_humid, 2), MSGW_Fmt(f2, htu_temp, 2));
     }
     else {
       sprintf (msgbuf, "HTU NF"); 
@@ -172,7 +174,7 @@ void StationMonitor() {
       float t,p;
       t = lps1.readTemperature();
       p = lps1.readPressure();
-      sprintf (msgbuf, "LPS1 P:%.2f T:%.2f", p, t);
+      sprintf (msgbuf, "LPS1 P:%s T:%s", MSGW_Fmt(f1, p, 2), MSGW_Fmt(f2, t, 2));
     }
     else {
       sprintf (msgbuf, "LPS1 NF");
@@ -184,7 +186,7 @@ void StationMonitor() {
       float t,p;
       t = lps2.readTemperature();
       p = lps2.readPressure();
-      sprintf (msgbuf, "LPS2 P:%.2f T:%.2f", p, t);
+      sprintf (msgbuf, "LPS2 P:%s T:%s", MSGW_Fmt(f1, p, 2), MSGW_Fmt(f2, t, 2));
     }
     else {
       sprintf (msgbuf, "LPS2 NF");
@@ -200,7 +202,7 @@ void StationMonitor() {
         t = -999.99;
         h = 0.0;
       }
-      sprintf (msgbuf, "HIH8 T%.2f H%.2f", t, h);
+      sprintf (msgbuf, "HIH8 T%s H%s", MSGW_Fmt(f1, t, 2), MSGW_Fmt(f2, h, 2));
     }
     else {
       sprintf (msgbuf, "HIH8 NF");
@@ -212,7 +214,7 @@ void StationMonitor() {
       float si_vis = uv.readVisible();
       float si_ir = uv.readIR();
       float si_uv = uv.readUV()/100.0;
-      sprintf (msgbuf, "SI V%.2f I%.2f U%.2f", si_vis, si_ir, si_uv);
+      sprintf (msgbuf, "SI V%s I%s U%s", MSGW_Fmt(f1, si_vis, 2), MSGW_Fmt(f2, si_ir, 2), MSGW_Fmt(f3, si_uv, 2));
     }
     else {
       sprintf (msgbuf, "SI NF");
@@ -222,7 +224,7 @@ void StationMonitor() {
   if (cycle == 14) {
     if (BLX_exists) {
       float lux = blx_takereading ();
-      sprintf (msgbuf, "BLX %.2f", lux);
+      sprintf (msgbuf, "BLX %s", MSGW_Fmt(f1, lux, 2));
     }
     else {
       sprintf (msgbuf, "BLX NF");
@@ -89,6 +89,19 @@ void Blink(int count, int between) {
   }
 }
 
+/*
+ * ======================================================================================================================
+ * DelaySince() - Wait until ms have passed since millis() was start, no wait if they already have
+ * ======================================================================================================================
+ */
+void DelaySince(unsigned long start, unsigned long ms) {
+  unsigned long elapsed = millis() - start;
+
+  if (elapsed < ms) {
+    delay(ms - elapsed);
+  }
+}
+
 /*
  * ======================================================================================================================
  * FadeOn() - https://www.dfrobot.com/blog-596.html
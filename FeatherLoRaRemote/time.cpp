@@ -7,6 +7,8 @@
 #include "include/output.h"
 #include "include/support.h"
 #include "include/gps.h"
+#include "include/msgw.h"
+#include "include/lora.h"
 #include "include/main.h"
 #include "include/time.h"
 
@@ -54,11 +56,18 @@ void rtc_timestamp() {
 
 /* 
  *=======================================================================================================================
- * rtc_refresh() - Get time from WiFi network or GPS and refresh the RTC, return true if time aquired
+ * rtc_refresh() - Get time from GPS, or the gateway when the RTC is not set, return true if time aquired
+ *                 Once set, gateway time beacons in the ACKs keep the RTC, See lora.h
  *=======================================================================================================================
  */
 bool rtc_refresh() {
-  return (gps_aquire());  // Our only time source
+  if (gps_aquire()) {
+    return (true);
+  }
+  if (!RTC_valid) {
+    return (LoRaTimeRequest());
+  }
+  return (false);
 }
 
 /* 